@@ -1,20 +1,80 @@
 #include "Control.h"
 
-void Control::generate_2DLSystem(img::EasyImage &image, const ini::Configuration &configuration) {
+namespace {
+
+    /**
+     * @brief Get primitive from the MeshCache, triangulated up front if it will be filled
+     */
+    Figure primitive(const std::string &key, const std::function<Figure()> &generate, const bool triangles) {
+        return MeshCache::get(triangles ? key + " triangulated" : key, [&generate, triangles]() {
+            Figure x = generate();
+            if (triangles) x.triangulate();
+            return x;
+        });
+    }
+}
+
+img::EasyImage Control::generate_image(const ini::Configuration &configuration) {
+
+    // General data for every image
+    std::string type = configuration["General"]["type"].as_string_or_die();
+    int size = configuration["General"]["size"].as_int_or_die();
+    std::vector<double> bg = configuration["General"]["backgroundcolor"].as_double_tuple_or_default({0, 0, 0});
+
+    // Scenes that do not fit the memory budget are streamed, or refused before anything is generated
+    Estimate::Scene scene;
+    if (Estimate::get_budget() != 0) {
+        scene = Estimate::plan(configuration);
+        if (!scene.fits) {
+            std::cerr << "Estimated " << scene.bytes << " bytes exceed the memory budget of " << scene.budget
+                      << " bytes" << std::endl;
+            throw std::bad_alloc();
+        }
+    }
+
+    // Create new image
+    img::EasyImage image = img::EasyImage(size, size, Utils::saturate_color(cc::Color(bg)));
+
+    // 2DLSystem as type
+    if (type == "2DLSystem") {
+        Control::generate_2DLSystem(image, configuration, scene.streamed);
+    }
+
+    else if (type == "Wireframe" || type == "ZBufferedWireframe" || type == "ZBuffering"
+             || type == "LightedZBuffering" || type == "Texture") {
+        Control::generate_3D(image, configuration, scene.streamed);
+    }
+    return image;
+}
+
+void Control::generate_2DLSystem(img::EasyImage &image, const ini::Configuration &configuration, const bool stream) {
 
         std::string file_name = configuration["2DLSystem"]["inputfile"].as_string_or_die();
         std::vector<double> color = configuration["2DLSystem"]["color"].as_double_tuple_or_default({0, 0, 0});
-        LParser::LSystem2D lSystem = Utils::LSystem2D(file_name);
+        uint64_t hash;
+        LParser::LSystem2D lSystem = LSystemCache::load_2D(file_name, hash);
 
+        // Stochastic rules are drawn from the seed, the same seed gives the same image
         if (lSystem.get_stochastic()) {
-            // Insert time seed
-            srand(time(NULL));
+            lSystem.set_seed(configuration["General"]["seed"].as_int_or_default(static_cast<int>(time(NULL))));
+        }
+        // Lines are drawn as the turtle makes them, memory no longer grows with the amount of lines
+        if (stream || configuration["General"]["streamLSystem"].as_bool_or_default(false)) {
+            Stats::ScopedTimer timer(Stats::RASTERIZE);
+            LSystem_2D::drawLSystem_streamed(lSystem, cc::Color(color), image.get_height(), image);
+            return;
         }
-        Lines2D LSystem_lines = LSystem_2D::drawLSystem(lSystem, cc::Color(color));
+        Lines2D LSystem_lines;
+        {
+            Stats::ScopedTimer timer(Stats::LSYSTEM);
+            LSystem_lines = LSystemCache::draw_2D(lSystem, hash, cc::Color(color),
+                                                  configuration["General"]["memoizeLSystem"].as_bool_or_default(false));
+        }
+        Stats::ScopedTimer timer(Stats::RASTERIZE);
         Line2D::draw2DLines(LSystem_lines, image.get_height(), image, false);
 }
 
-void Control::generate_3D(img::EasyImage &image, const ini::Configuration &configuration) {
+void Control::generate_3D(img::EasyImage &image, const ini::Configuration &configuration, const bool stream) {
 
      // General data for all figures
      std::string type = configuration["General"]["type"].as_string_or_die();
@@ -37,13 +97,14 @@ void Control::generate_3D(img::EasyImage &image, const ini::Configuration &confi
      // Hold all lines figures
      Figures3D figures_lineDrawings;
 
-     Control::generate_figures(figures, type, configuration, LINES, TEXTURE, LIGHT, figures_lineDrawings);
+     {
+         Stats::ScopedTimer timer(Stats::GENERATE_FIGURES);
+         Control::generate_figures(figures, type, configuration, LINES, TEXTURE, LIGHT, figures_lineDrawings, stream);
+     }
 
      Matrix eyeMatrix = Figure::eye_point_trans(Vector3D::point(eye[0], eye[1], eye[2]));
 
      Lights3D lights;
-     Lines2D lines;
-     Lines2D lineDrawing_lines;
 
     if (LIGHT) Control::generate_lights(configuration, SHADOW, eyeMatrix, TEXTURE, lights);
 
@@ -52,14 +113,14 @@ void Control::generate_3D(img::EasyImage &image, const ini::Configuration &confi
         bool ZBuffered = false;
         if (type == "ZBufferedWireframe") ZBuffered = true;
 
-        Utils::generate_lines(figures, lines, eyeMatrix);
-        Line2D::draw2DLines(lines, configuration["General"]["size"].as_int_or_die(), image, ZBuffered);
+        Stats::ScopedTimer timer(Stats::RASTERIZE);
+        Utils::draw_wireframe(figures, eyeMatrix, configuration["General"]["size"].as_int_or_die(), image,
+                              ZBuffered);
 
         // TODO - !figures.empty()
         if (LINES) {
-            Utils::generate_lines(figures_lineDrawings, lineDrawing_lines, eyeMatrix);
-            if (figures.empty()) Line2D::draw2DLines(lineDrawing_lines, configuration["General"]["size"].as_int_or_die(),
-                                                     image, true);
+            if (figures.empty()) Utils::draw_wireframe(figures_lineDrawings, eyeMatrix,
+                                                       configuration["General"]["size"].as_int_or_die(), image, true);
             }
         }
 
@@ -72,35 +133,60 @@ void Control::generate_3D(img::EasyImage &image, const ini::Configuration &confi
         double dy;
         ZBuffer buffer = ZBuffer(0, 0);
 
+        // False-colour image of the rasterizer costs instead of the shaded render
+        std::string debug_name = configuration["General"]["debugView"].as_string_or_default("none");
+        DebugView debug_view(DebugView::parse_mode(debug_name));
+        if (debug_view.getMode() == DebugView::NONE && debug_name != "none") {
+            std::cerr << "Unknown debugView: " << debug_name << std::endl;
+        }
+
         if (!figures.empty()) {
-            Control::draw_triangles(figures, lines, eyeMatrix, configuration["General"]["size"].as_int_or_die(),
-                                    SHADOW, configuration, lights, image_x, image_y, d, dx, dy, buffer, image);
+            Control::draw_triangles(figures, eyeMatrix, configuration["General"]["size"].as_int_or_die(),
+                                    SHADOW, configuration, lights, image_x, image_y, d, dx, dy, buffer, image,
+                                    debug_view.getMode() != DebugView::NONE ? &debug_view : nullptr);
         }
         if (LINES) {
-            Utils::generate_lines(figures_lineDrawings, lineDrawing_lines, eyeMatrix);
-            if (figures.empty()) Line2D::draw2DLines(lineDrawing_lines, configuration["General"]["size"].as_int_or_die(),
-                                                     image, true);
-            else {
-                for (Line2D &i : lineDrawing_lines) {
-                    i.line2D_scale(d);
-                    i.line2D_move(dx, dy);
-                    i.round();
-
-                    image.draw_line(static_cast<int>(std::round(i.getP1().getX())),
-                                    static_cast<int>(std::round(i.getP1().getY())),
-                                    static_cast<int>(std::round(i.getP2().getX())),
-                                    static_cast<int>(std::round(i.getP2().getY())),
-                                    Utils::saturate_color(i.getColor()));
-                }
-            }
+            if (figures.empty()) Utils::draw_wireframe(figures_lineDrawings, eyeMatrix,
+                                                       configuration["General"]["size"].as_int_or_die(), image, true);
+            else Utils::draw_projected_lines(figures_lineDrawings, eyeMatrix, d, dx, dy, image, nullptr);
         }
+        if (debug_view.getMode() != DebugView::NONE && !figures.empty()) debug_view.draw(image);
     }
 }
 
 void Control::generate_figures(Figures3D &figures, const std::string &type, const ini::Configuration &configuration,
-                               bool &LINES, bool &TEXTURE, bool &LIGHT, Figures3D &lineDrawings) {
-
-    std::ignore = type;
+                               bool &LINES, bool &TEXTURE, bool &LIGHT, Figures3D &lineDrawings,
+                               const bool stream) {
+
+    // Faces hidden inside a MengerSponge are only left out when they would be filled
+    const bool triangles = type == "ZBuffering" || type == "LightedZBuffering" || type == "Texture";
+
+    // Report meshes that are not closed, off by default since every edge is hashed
+    const bool validate = configuration["General"]["validateMeshes"].as_bool_or_default(false);
+    auto validate_mesh = [](const Figure &figure, const std::string &figure_name, const std::string &figure_type) {
+        std::size_t open_edges = Utils::open_edges(figure);
+        if (open_edges != 0) {
+            std::cerr << figure_name << " (" << figure_type << ") is not watertight, " << open_edges
+                      << " open edges" << std::endl;
+        }
+    };
+
+    // Primitives are shared through the MeshCache, triangulated up front if they will be filled
+    auto platonic = [triangles](const std::string &key, const std::function<Figure()> &generate) {
+        return primitive(key, generate, triangles);
+    };
+    auto round_primitive = [&](const std::string &figure_name, const std::string &figure_type,
+                               const int n, const int m) {
+        return Control::round_primitive(configuration, figure_name, figure_type, n, m, triangles);
+    };
+
+    // Figures with lod = auto, their tessellation follows their size in the image
+    struct AutoLod {
+        Figures3D::iterator figure;
+        std::string name;
+        std::string type;
+    };
+    std::vector<AutoLod> auto_lods;
 
     int nr_figures = configuration["General"]["nrFigures"].as_int_or_die();
     // Traverse all figures inside .ini file
@@ -108,14 +194,16 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
 
         Figure figure;
 
+        bool is_lod = false;
         bool is_lineDrawing = false;
         bool is_fractal = false;
         bool is_mengerSponge = false;
         std::string figure_name = "Figure" + std::to_string(i);
         std::string figure_type = configuration[figure_name]["type"].as_string_or_die();
+        Trace::Span figure_span(figure_name + " (" + figure_type + ")");
 
         if (figure_type == "Cube") {
-            figure = Platonic::cube();
+            figure = platonic(MeshCache::key(figure_type, {}), Platonic::cube);
         }
 
         else if (figure_type == "FractalCube") {
@@ -124,7 +212,7 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
         }
 
         else if (figure_type == "Tetrahedron") {
-            figure = Platonic::tetrahedron();
+            figure = platonic(MeshCache::key(figure_type, {}), Platonic::tetrahedron);
         }
 
         else if (figure_type == "FractalTetrahedron") {
@@ -133,7 +221,7 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
         }
 
         else if (figure_type == "Octahedron") {
-            figure = Platonic::octahedron();
+            figure = platonic(MeshCache::key(figure_type, {}), Platonic::octahedron);
         }
 
         else if (figure_type == "FractalOctahedron") {
@@ -142,7 +230,7 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
         }
 
         else if (figure_type == "Icosahedron") {
-            figure = Platonic::icosahedron();
+            figure = platonic(MeshCache::key(figure_type, {}), Platonic::icosahedron);
         }
 
         else if (figure_type == "FractalIcosahedron") {
@@ -151,7 +239,7 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
         }
 
         else if (figure_type == "Dodecahedron") {
-            figure = Platonic::dodecahedron();
+            figure = platonic(MeshCache::key(figure_type, {}), Platonic::dodecahedron);
         }
 
         else if (figure_type == "FractalDodecahedron") {
@@ -160,7 +248,7 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
         }
 
         else if (figure_type == "BuckyBall") {
-            figure = Platonic::buckyBall();
+            figure = platonic(MeshCache::key(figure_type, {}), Platonic::buckyBall);
         }
 
         else if (figure_type == "FractalBuckyBall") {
@@ -168,25 +256,23 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
             is_fractal = true;
         }
 
-        else if (figure_type == "Sphere") {
-            figure = Platonic::sphere(configuration[figure_name]["n"].as_int_or_die());
-        }
-
-        else if (figure_type == "Cone") {
-            figure = Platonic::cone(configuration[figure_name]["n"].as_int_or_die(),
-                                    configuration[figure_name]["height"].as_double_or_die());
-        }
-
-        else if (figure_type == "Cylinder") {
-            figure = Platonic::cylinder(configuration[figure_name]["n"].as_int_or_die(),
-                                        configuration[figure_name]["height"].as_double_or_die());
-        }
-
-        else if (figure_type == "Torus") {
-            figure = Platonic::torus(configuration[figure_name]["r"].as_double_or_die(),
-                                     configuration[figure_name]["R"].as_double_or_die(),
-                                     configuration[figure_name]["n"].as_double_or_die(),
-                                     configuration[figure_name]["m"].as_double_or_die());
+        else if (figure_type == "Sphere" || figure_type == "Cone" || figure_type == "Cylinder" || figure_type == "Torus") {
+            // Start from a coarse mesh, the tessellation is chosen once the size of the image is known
+            if (configuration[figure_name]["lod"].as_string_or_default("fixed") == "auto") {
+                const int coarse = figure_type == "Sphere" ? Platonic::COARSE_SPHERE_LEVEL
+                                                           : Platonic::COARSE_CIRCLE_SEGMENTS;
+                figure = round_primitive(figure_name, figure_type, coarse, coarse);
+                is_lod = true;
+            }
+            // Torus reads its amount of points as a double
+            else if (figure_type == "Torus") {
+                figure = round_primitive(figure_name, figure_type,
+                                         static_cast<int>(configuration[figure_name]["n"].as_double_or_die()),
+                                         static_cast<int>(configuration[figure_name]["m"].as_double_or_die()));
+            }
+            else {
+                figure = round_primitive(figure_name, figure_type, configuration[figure_name]["n"].as_int_or_die(), 0);
+            }
         }
 
         else if (figure_type == "MengerSponge") {
@@ -200,8 +286,9 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
             is_lineDrawing = true;
 
             std::string file_name = configuration[figure_name]["inputfile"].as_string_or_die();
-            LParser::LSystem3D lSystem = Utils::LSystem3D(file_name);
-            figure = LSystem_3D::drawLSystem(lSystem);
+            uint64_t hash;
+            LParser::LSystem3D lSystem = LSystemCache::load_3D(file_name, hash);
+            figure = LSystemCache::draw_3D(lSystem, hash);
         }
 
         else if (figure_type == "LineDrawing") {
@@ -213,24 +300,101 @@ void Control::generate_figures(Figures3D &figures, const std::string &type, cons
             Control::generate_lines(figure, nr_points, nr_lines, configuration, figure_name);
         }
 
-        Figures3D fractal;
+        // Figures with lod = auto are checked once their final mesh is chosen
+        if (validate && !is_lineDrawing && !is_lod) validate_mesh(figure, figure_name, figure_type);
+
         if (is_fractal) {
+            Stats::ScopedTimer timer(Stats::FRACTAL);
             double fractal_scale = 3;
             if (!is_mengerSponge) {
                 fractal_scale = configuration[figure_name]["fractalScale"].as_double_or_die();
             }
-            Utils::fractal(figure, fractal,
-                           configuration[figure_name]["nrIterations"].as_int_or_die(),
-                           fractal_scale, is_mengerSponge);
+            int iterations = configuration[figure_name]["nrIterations"].as_int_or_die();
+            // The last iterations of a sponge are merged into the base mesh, the first ones stay copies of it
+            int merged = 0;
+            if (is_mengerSponge && triangles) merged = std::min(iterations, Utils::MENGER_MERGED_LEVELS);
+            Utils::fractal(figure, iterations - merged, fractal_scale, is_mengerSponge,
+                           stream || configuration["General"]["streamFractals"].as_bool_or_default(false));
+            if (merged != 0) Utils::merge_menger_sponge(figure, merged);
         }
 
         Matrix trans_matrix;
         std::vector<double> origin;
         Control::generate_transMatrix(trans_matrix, origin, configuration, figure_name);
 
-        Control::setup_figures(fractal, figure, figures, figure_name, configuration, trans_matrix, origin,
-                               TEXTURE, LIGHT, is_lineDrawing, lineDrawings);
+        Control::setup_figures(figure, figures, figure_name, configuration, trans_matrix, origin,
+                               TEXTURE, LIGHT, is_lineDrawing, is_fractal, lineDrawings);
+        if (is_lod) auto_lods.push_back(AutoLod{std::prev(figures.end()), figure_name, figure_type});
+    }
+
+    if (auto_lods.empty()) return;
+
+    // Scale of the image with the coarse meshes, close enough to the final one to choose a tessellation
+    std::vector<double> eye = configuration["General"]["eye"].as_double_tuple_or_die();
+    const Matrix eye_matrix = Figure::eye_point_trans(Vector3D::point(eye[0], eye[1], eye[2]));
+    const double d = std::get<2>(Utils::prep_zbuffering(figures, eye_matrix,
+                                                        configuration["General"]["size"].as_int_or_die()));
+    for (const AutoLod &i : auto_lods) {
+        Trace::Span lod_span(i.name + " (lod)");
+        const Control::Lod lod = Control::choose_lod(configuration, i.name, i.type, *i.figure, eye_matrix, d);
+        const Figure chosen = round_primitive(i.name, i.type, lod.n, lod.m);
+        if (validate) validate_mesh(chosen, i.name, i.type);
+        i.figure->share_mesh(chosen);
+        Stats::lods().push_back(Stats::Lod{i.name, lod.level, lod.pixels});
+    }
+}
+
+Figure Control::round_primitive(const ini::Configuration &configuration, const std::string &figure_name,
+                                const std::string &figure_type, const int n, const int m, const bool triangles) {
+
+    if (figure_type == "Sphere") {
+        return primitive(MeshCache::key(figure_type, {double(n)}), [n]() {
+            return Platonic::sphere(n);
+        }, triangles);
+    }
+    if (figure_type == "Torus") {
+        const double r = configuration[figure_name]["r"].as_double_or_die();
+        const double R = configuration[figure_name]["R"].as_double_or_die();
+        return primitive(MeshCache::key(figure_type, {r, R, double(n), double(m)}), [r, R, n, m]() {
+            return Platonic::torus(r, R, n, m);
+        }, triangles);
+    }
+    const double height = configuration[figure_name]["height"].as_double_or_die();
+    return primitive(MeshCache::key(figure_type, {double(n), height}), [figure_type, n, height]() {
+        return figure_type == "Cone" ? Platonic::cone(n, height) : Platonic::cylinder(n, height);
+    }, triangles);
+}
+
+Control::Lod Control::choose_lod(const ini::Configuration &configuration, const std::string &figure_name,
+                                 const std::string &figure_type, const Figure &coarse, const Matrix &eye_matrix,
+                                 const double d) {
+
+    Points3D scratch;
+    Transform::Bounds bounds;
+    coarse.project_bounds(eye_matrix, scratch, bounds);
+    Lod lod;
+    lod.pixels = d * std::max(bounds.x_max - bounds.x_min, bounds.y_max - bounds.y_min);
+    const double edge = configuration[figure_name]["lodEdgeLength"].as_double_or_default(4);
+
+    // The projection spans the widest side of the primitive, which gives the pixels per unit of its model
+    if (figure_type == "Sphere") {
+        lod.n = Platonic::sphere_level(lod.pixels / 2, edge);
+        lod.level = "n=" + std::to_string(lod.n);
+    }
+    else if (figure_type == "Torus") {
+        const double r = configuration[figure_name]["r"].as_double_or_die();
+        const double R = configuration[figure_name]["R"].as_double_or_die();
+        const double unit = lod.pixels / (2 * (R + r));
+        lod.n = Platonic::circle_segments((R + r) * unit, edge);
+        lod.m = Platonic::circle_segments(r * unit, edge);
+        lod.level = "n=" + std::to_string(lod.n) + " m=" + std::to_string(lod.m);
     }
+    else {
+        const double height = configuration[figure_name]["height"].as_double_or_die();
+        lod.n = Platonic::circle_segments(lod.pixels / std::max(2.0, height), edge);
+        lod.level = "n=" + std::to_string(lod.n);
+    }
+    return lod;
 }
 
 void Control::generate_lines(Figure &figure, const int nr_points, const int nr_lines, const ini::Configuration &configuration,
@@ -245,7 +409,7 @@ void Control::generate_lines(Figure &figure, const int nr_points, const int nr_l
     for (int j = 0; j < nr_lines; j++) {
         std::string line_name = "line" + std::to_string(j);
         std::vector<int> line = configuration[figure_name][line_name].as_int_tuple_or_die();
-        figure.get_faces().emplace_back(Face(line));
+        figure.add_face(line);
     }
 }
 
@@ -266,70 +430,42 @@ void Control::generate_transMatrix(Matrix &trans_matrix, std::vector<double> &or
                   * Figure::translate(Vector3D::point(origin[0], origin[1], origin[2]));
 }
 
-void Control::setup_figures(Figures3D &fractal, Figure &figure, Figures3D &figures, const std::string &figure_name,
+void Control::setup_figures(Figure &figure, Figures3D &figures, const std::string &figure_name,
                             const ini::Configuration &configuration, const Matrix &trans_matrix, const std::vector<double> &origin,
-                            const bool &TEXTURE, const bool &LIGHT, const bool &is_lineDrawing, Figures3D &lineDrawings) {
-
-    if (!fractal.empty()) {
-        for (Figure & fig : fractal) {
-            if (!LIGHT) {
-                fig.setAmbientReflection(configuration[figure_name]["color"].as_double_tuple_or_default({0, 0, 0}));
-            }
-            else {
-                fig.setAmbientReflection(configuration[figure_name]["ambientReflection"].as_double_tuple_or_default({0, 0, 0}));
-                fig.setDiffuseReflection(configuration[figure_name]["diffuseReflection"].as_double_tuple_or_default({0, 0, 0}));
-                fig.setSpecularReflection(configuration[figure_name]["specularReflection"].as_double_tuple_or_default({0, 0, 0}));
-                fig.setReflectionCoefficient(configuration[figure_name]["reflectionCoefficient"].as_double_or_default(0));
-            }
-            fig.apply_transformation(trans_matrix);
-
-            fig.setTextureFlag(false);
-            bool texture_exists = false;
-            if (configuration[figure_name]["textureName"].exists()) texture_exists = true;
+                            const bool &TEXTURE, const bool &LIGHT, const bool &is_lineDrawing, const bool &is_fractal,
+                            Figures3D &lineDrawings) {
 
-            if (TEXTURE && texture_exists) {
-                std::ifstream fin(configuration[figure_name]["textureName"].as_string_or_die());
-                img::EasyImage new_texture;
-                fin >> new_texture;
-                fin.close();
-                fig.setTexture(new_texture);
-                fig.setTextureFlag(true);
-            }
-            figures.emplace_back(fig);
-        }
+    if (!LIGHT) {
+        figure.setAmbientReflection(configuration[figure_name]["color"].as_double_tuple_or_default({0, 0, 0}));
+    }
+    else {
+        figure.setAmbientReflection(configuration[figure_name]["ambientReflection"].as_double_tuple_or_default({0, 0, 0}));
+        figure.setDiffuseReflection(configuration[figure_name]["diffuseReflection"].as_double_tuple_or_default({0, 0, 0}));
+        figure.setSpecularReflection(configuration[figure_name]["specularReflection"].as_double_tuple_or_default({0, 0, 0}));
+        figure.setReflectionCoefficient(configuration[figure_name]["reflectionCoefficient"].as_double_or_default(0));
+    }
+    figure.set_model(trans_matrix);
+
+    figure.setTextureFlag(false);
+    bool texture_exists = false;
+    if (configuration[figure_name]["textureName"].exists()) texture_exists = true;
+
+    if (TEXTURE && texture_exists) {
+        std::ifstream fin(configuration[figure_name]["textureName"].as_string_or_die());
+        img::EasyImage new_texture;
+        fin >> new_texture;
+        fin.close();
+        figure.setTexture(new_texture);
+        figure.setTextureFlag(true);
+        // Copies of a fractal keep the default center
+        if (!is_fractal) figure.setCenter(Vector3D::point(origin[0], origin[1], origin[2]));
     }
-    else{
-        if (!LIGHT) {
-            figure.setAmbientReflection(configuration[figure_name]["color"].as_double_tuple_or_default({0, 0, 0}));
-        }
-        else {
-            figure.setAmbientReflection(configuration[figure_name]["ambientReflection"].as_double_tuple_or_default({0, 0, 0}));
-            figure.setDiffuseReflection(configuration[figure_name]["diffuseReflection"].as_double_tuple_or_default({0, 0, 0}));
-            figure.setSpecularReflection(configuration[figure_name]["specularReflection"].as_double_tuple_or_default({0, 0, 0}));
-            figure.setReflectionCoefficient(configuration[figure_name]["reflectionCoefficient"].as_double_or_default(0));
-        }
-        figure.apply_transformation(trans_matrix);
-
-        figure.setTextureFlag(false);
-        bool texture_exists = false;
-        if (configuration[figure_name]["textureName"].exists()) texture_exists = true;
-
-        if (TEXTURE && texture_exists) {
-            std::ifstream fin(configuration[figure_name]["textureName"].as_string_or_die());
-            img::EasyImage new_texture;
-            fin >> new_texture;
-            fin.close();
-            figure.setTexture(new_texture);
-            figure.setTextureFlag(true);
-            figure.setCenter(Vector3D::point(origin[0], origin[1], origin[2]));
-        }
 
-        if (is_lineDrawing) {
-            lineDrawings.emplace_back(figure);
-        }
-        else {
-            figures.emplace_back(figure);
-        }
+    if (is_lineDrawing) {
+        lineDrawings.emplace_back(figure);
+    }
+    else {
+        figures.emplace_back(figure);
     }
 }
 
@@ -416,48 +552,63 @@ void Control::generate_lights(const ini::Configuration &configuration, const boo
     }
 }
 
-void Control::draw_triangles(Figures3D &figures, Lines2D &lines, Matrix &eyeMatrix,
+void Control::draw_triangles(Figures3D &figures, Matrix &eyeMatrix,
                              const int size, const bool &SHADOW, const ini::Configuration &configuration,
                              Lights3D &lights, double &image_x, double &image_y, double &d, double &dx,
-                             double &dy, ZBuffer &buffer, img::EasyImage &image) {
+                             double &dy, ZBuffer &buffer, img::EasyImage &image, DebugView *debug_view) {
+
+    {
+        Stats::ScopedTimer timer(Stats::PREP_ZBUFFERING);
+        Utils::triangulate_figures(figures);
+    }
 
+    // Create shadowMask for every light if SHADOW == true, figures are still in model-coordinates
+    if (SHADOW) {
+        Stats::ScopedTimer timer(Stats::SHADOW_MASK);
+        int light_index = 0;
+        for (Light *i : lights) {
+            std::string light_name = "Light" + std::to_string(light_index++);
+            if (i->getName() == "POINT") {
+                Trace::Span light_span("shadow pass " + light_name);
+                i->createShadowMask(figures, configuration["General"]["shadowMask"].as_int_or_die());
+            }
+        }
+    }
+
+    Stats::ScopedTimer prep_timer(Stats::PREP_ZBUFFERING);
     std::tuple<double, double,
                double, double,
-               double, Figures3D> return_data = Utils::prep_zbuffering(figures, lines,
-                                                                       eyeMatrix, size);
+               double> return_data = Utils::prep_zbuffering(figures, eyeMatrix, size);
 
     image_x = std::get<0>(return_data);
     image_y = std::get<1>(return_data);
     d = std::get<2>(return_data);
     dx = std::get<3>(return_data);
     dy = std::get<4>(return_data);
-    Figures3D triangulated_figures = std::get<5>(return_data);
 
     // Create buffer
     buffer = ZBuffer( (unsigned int) std::round(image_x), (unsigned int) std::round(image_y));
     // Resize image
     image.image_resize( (int) std::round(image_x), (int) std::round(image_y));
-
-    // Create shadowMask for every light if SHADOW == true
-    if (SHADOW) {
-        for (Light *i : lights) {
-            if (i->getName() == "POINT") {
-                i->createShadowMask(triangulated_figures,
-                                    configuration["General"]["shadowMask"].as_int_or_die());
-            }
-        }
-    }
+    if (debug_view) debug_view->reset(image.get_width(), image.get_height());
+    prep_timer.stop();
 
     // Traverse created triangles and draw
-    for (Figure & i : figures) {
-        for (Face & j : i.get_faces()) {
-
-            image.draw_zbuf_triag(buffer, i.get_points()[j.get_point_indexes()[0]],
-                                  i.get_points()[j.get_point_indexes()[1]],
-                                  i.get_points()[j.get_point_indexes()[2]],
-                                  d, dx, dy, i.getAmbientReflection(), i.getDiffuseReflection(),
-                                  i.getSpecularReflection(), i.getReflectionCoefficient(), lights,
-                                  eyeMatrix, SHADOW, i.getTexture(), i.isTexture(), i.getCenter());
-        }
+    Stats::ScopedTimer timer(Stats::RASTERIZE);
+    Points3D points;
+    for (const Figure & i : figures) {
+        // Instances are brought to eye-coordinates one at a time, only the base mesh is kept in memory
+        Utils::for_each_instance(i, eyeMatrix, [&](const Matrix &transformation) {
+            points = i.get_points();
+            points.transform(transformation);
+
+            for (const Triangle & j : i.get_triangles()) {
+
+                image.draw_zbuf_triag(buffer, points[j.a], points[j.b], points[j.c],
+                                      d, dx, dy, i.getAmbientReflection(), i.getDiffuseReflection(),
+                                      i.getSpecularReflection(), i.getReflectionCoefficient(), lights,
+                                      eyeMatrix, SHADOW, i.getTexture(), i.isTexture(), i.getCenter(), debug_view);
+            }
+        });
     }
 }
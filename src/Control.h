@@ -1,6 +1,7 @@
 #ifndef CONTROL_H
 #define CONTROL_H
 
+#include <iterator>
 #include <list>
 #include "easy_image.h"
 #include "ini_configuration.h"
@@ -10,6 +11,12 @@
 #include "LSystem2D.h"
 #include "LSystem3D.h"
 #include "Light.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "DebugView.h"
+#include "MeshCache.h"
+#include "LSystemCache.h"
+#include "Estimate.h"
 
 /**
  * @brief List containing of Line2D objects.
@@ -21,21 +28,32 @@ typedef std::list<Line2D> Lines2D;
  */
 namespace Control {
 
+    /**
+     * @brief Generates a image off a .ini file
+     *
+     * @param configuration Contains .ini data
+     *
+     * @return img::EasyImage object-type
+     */
+    img::EasyImage generate_image(const ini::Configuration &configuration);
+
     /**
      * @brief Generate 2DLSystem
      *
      * @param image Image to be generated
      * @param configuration Contains .ini data
+     * @param stream Draw the LSystem without keeping its lines, see Estimate::plan
      */
-    void generate_2DLSystem(img::EasyImage &image, const ini::Configuration &configuration);
+    void generate_2DLSystem(img::EasyImage &image, const ini::Configuration &configuration, const bool stream = false);
 
     /**
      * @brief Generate a 3D image
      *
      * @param image Image to be generated
      * @param configuration Contains .ini data
+     * @param stream Generate copies of fractals while drawing, see Estimate::plan
      */
-    void generate_3D(img::EasyImage &image, const ini::Configuration &configuration);
+    void generate_3D(img::EasyImage &image, const ini::Configuration &configuration, const bool stream = false);
 
     /**
      * @brief Generate 3D figures and draw these onto given image
@@ -47,9 +65,58 @@ namespace Control {
      * @param TEXTURE Is image type "Texture"
      * @param LIGHT Does image contain lights
      * @param lineDrawings List of 3D figures containing line drawings
+     * @param stream Generate copies of fractals while drawing, see Estimate::plan
      */
     void generate_figures(Figures3D &figures, const std::string &type, const ini::Configuration &configuration,
-                          bool &LINES, bool &TEXTURE, bool &LIGHT, Figures3D &lineDrawings);
+                          bool &LINES, bool &TEXTURE, bool &LIGHT, Figures3D &lineDrawings, const bool stream = false);
+
+    /**
+     * @brief Tessellation chosen for a Sphere, Cone, Cylinder or Torus with lod = "auto"
+     */
+    struct Lod {
+        int n = 0;
+        int m = 0;
+        /**
+         * @brief Projected size of the coarse mesh in pixels
+         */
+        double pixels = 0;
+        /**
+         * @brief Chosen parameters of the generator, e.g. "n=4"
+         */
+        std::string level;
+    };
+
+    /**
+     * @brief Get Sphere, Cone, Cylinder or Torus with given amount of points through the MeshCache, the other
+     * parameters are read from the .ini file
+     *
+     * @param configuration Contains .ini data
+     * @param figure_name Name of figure in configuration as string
+     * @param figure_type Type of the figure
+     * @param n Subdivisions of a Sphere, points on a circle otherwise
+     * @param m Points on the tube of a Torus
+     * @param triangles Triangulate the mesh, the figure will be filled
+     *
+     * @return Figure sharing the cached mesh
+     */
+    Figure round_primitive(const ini::Configuration &configuration, const std::string &figure_name,
+                           const std::string &figure_type, const int n, const int m, const bool triangles);
+
+    /**
+     * @brief Choose tessellation of a figure with lod = "auto" from the size of its coarse mesh in the image, used by
+     * generate_figures and by Estimate so both pick the same one
+     *
+     * @param configuration Contains .ini data
+     * @param figure_name Name of figure in configuration as string
+     * @param figure_type Sphere, Cone, Cylinder or Torus
+     * @param coarse Figure with the coarse mesh and its model transformation
+     * @param eye_matrix Eye transformation
+     * @param d Scale of the image, see Utils::prep_zbuffering
+     *
+     * @return Chosen tessellation
+     */
+    Lod choose_lod(const ini::Configuration &configuration, const std::string &figure_name,
+                   const std::string &figure_type, const Figure &coarse, const Matrix &eye_matrix, const double d);
 
     /**
      * @brief generate_lines Generate lines for given figure
@@ -77,8 +144,7 @@ namespace Control {
     /**
      * @brief setup_figures
      *
-     * @param fractal List of 3D figures if figure was a fractal
-     * @param figure 3D figure
+     * @param figure 3D figure, holds its instances if it is a fractal
      * @param figures List containing all figures of image
      * @param figure_name Name of figure in configuration as string
      * @param configuration Contains .ini data
@@ -87,11 +153,13 @@ namespace Control {
      * @param TEXTURE Is image type "Texture"
      * @param LIGHT Does image contain lights
      * @param is_lineDrawing
+     * @param is_fractal Figure holds a fractal, its copies keep the default center
      * @param lineDrawings List of 3D figures containing line drawings
      */
-    void setup_figures(Figures3D &fractal, Figure &figure, Figures3D &figures, const std::string &figure_name,
+    void setup_figures(Figure &figure, Figures3D &figures, const std::string &figure_name,
                        const ini::Configuration &configuration, const Matrix &trans_matrix, const std::vector<double> &origin,
-                       const bool &TEXTURE, const bool &LIGHT, const bool &is_lineDrawing, Figures3D &lineDrawings);
+                       const bool &TEXTURE, const bool &LIGHT, const bool &is_lineDrawing, const bool &is_fractal,
+                       Figures3D &lineDrawings);
 
     /**
      * @brief generate_lights
@@ -105,10 +173,10 @@ namespace Control {
     void generate_lights(const ini::Configuration &configuration, const bool &SHADOW, const Matrix &eyeMatrix,
                          const bool &TEXTURE, Lights3D &lights);
 
-    void draw_triangles(Figures3D &figures, Lines2D &lines, Matrix &eyeMatrix,
+    void draw_triangles(Figures3D &figures, Matrix &eyeMatrix,
                         const int size, const bool &SHADOW, const ini::Configuration &configuration,
                         Lights3D &lights, double &image_x, double &image_y, double &d, double &dx,
-                        double &dy, ZBuffer &buffer, img::EasyImage &image);
+                        double &dy, ZBuffer &buffer, img::EasyImage &image, DebugView *debug_view = nullptr);
 }
 
 #endif // CONTROL_H
@@ -0,0 +1,90 @@
+//
+// Created by Pablo Deputter on 06/05/2021.
+//
+
+#include "DebugView.h"
+#include <algorithm>
+
+DebugView::DebugView(const Mode &mode) : mode(mode), width(0), height(0), triangle(0) {}
+
+DebugView::Mode DebugView::parse_mode(const std::string &name) {
+
+    if (name == "overdraw") return OVERDRAW;
+    if (name == "shading") return SHADING_COST;
+    if (name == "shadow") return SHADOW_LOOKUPS;
+    if (name == "tiles") return TRIANGLES_PER_TILE;
+    return NONE;
+}
+
+unsigned int DebugView::tiles_x() const {
+    return (width + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+unsigned int DebugView::tiles_y() const {
+    return (height + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+void DebugView::reset(const unsigned int width, const unsigned int height) {
+
+    this->width = width;
+    this->height = height;
+    triangle = 0;
+    if (mode == TRIANGLES_PER_TILE) {
+        counts.assign(tiles_x() * tiles_y(), 0);
+        tile_stamps.assign(tiles_x() * tiles_y(), 0);
+    }
+    else {
+        counts.assign(width * height, 0);
+        tile_stamps.clear();
+    }
+}
+
+void DebugView::add_span(const unsigned int y, const unsigned int xl, const unsigned int xr) {
+
+    if (mode != TRIANGLES_PER_TILE || xl >= xr) return;
+
+    unsigned int ty = y / TILE_SIZE;
+    for (unsigned int tx = xl / TILE_SIZE; tx <= (xr - 1) / TILE_SIZE; tx++) {
+        unsigned int index = tx * tiles_y() + ty;
+        if (tile_stamps[index] != triangle) {
+            tile_stamps[index] = triangle;
+            counts[index]++;
+        }
+    }
+}
+
+uint32_t DebugView::max_count() const {
+
+    if (counts.empty()) return 0;
+    return *std::max_element(counts.begin(), counts.end());
+}
+
+void DebugView::draw(img::EasyImage &image) const {
+
+    const double max = static_cast<double>(max_count());
+
+    for (unsigned int x = 0; x != width; x++) {
+        for (unsigned int y = 0; y != height; y++) {
+
+            uint32_t count = mode == TRIANGLES_PER_TILE ? counts[(x / TILE_SIZE) * tiles_y() + y / TILE_SIZE]
+                                                        : counts[x * height + y];
+            image(x, y) = heat_color(max > 0 ? count / max : 0);
+        }
+    }
+}
+
+img::Color DebugView::heat_color(double x) {
+
+    x = std::max(0.0, std::min(1.0, x));
+    if (x == 0) return img::Color(0, 0, 0);
+
+    // Black -> blue -> green -> yellow -> red, every part covers a quarter
+    const double stops[5][3] = {{0, 0, 0}, {0, 0, 255}, {0, 255, 0}, {255, 255, 0}, {255, 0, 0}};
+    double position = x * 4;
+    int i = std::min(3, static_cast<int>(position));
+    double t = position - i;
+
+    return img::Color(static_cast<uint8_t>(std::round(stops[i][0] + (stops[i + 1][0] - stops[i][0]) * t)),
+                      static_cast<uint8_t>(std::round(stops[i][1] + (stops[i + 1][1] - stops[i][1]) * t)),
+                      static_cast<uint8_t>(std::round(stops[i][2] + (stops[i + 1][2] - stops[i][2]) * t)));
+}
@@ -0,0 +1,152 @@
+//
+// Created by Pablo Deputter on 06/05/2021.
+//
+
+#ifndef ENGINE_DEBUGVIEW_H
+#define ENGINE_DEBUGVIEW_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "easy_image.h"
+
+/**
+ * @brief The DebugView class, gathers per-pixel costs of the rasterizer and turns them into a false-colour image
+ *
+ * Selected with [General] debugView, the counts are gathered by draw_zbuf_triag while it renders the scene.
+ */
+class DebugView {
+public:
+    /**
+     * @brief Quantity that is visualised
+     */
+    enum Mode {
+        NONE = 0,
+        OVERDRAW,
+        SHADING_COST,
+        SHADOW_LOOKUPS,
+        TRIANGLES_PER_TILE
+    };
+
+    /**
+     * @brief Width and height in pixels of a tile for TRIANGLES_PER_TILE
+     */
+    static const unsigned int TILE_SIZE = 16;
+
+private:
+    /**
+     * @brief Selected mode
+     */
+    Mode mode;
+    /**
+     * @brief Width of image
+     */
+    unsigned int width;
+    /**
+     * @brief Height of image
+     */
+    unsigned int height;
+    /**
+     * @brief Count per pixel, or per tile for TRIANGLES_PER_TILE, indexed x * height + y
+     */
+    std::vector<uint32_t> counts;
+    /**
+     * @brief Last triangle that touched a tile, so a triangle is only counted once per tile
+     */
+    std::vector<uint32_t> tile_stamps;
+    /**
+     * @brief Number of current triangle, starts at 1 because stamps are 0 initially
+     */
+    uint32_t triangle;
+
+    unsigned int tiles_x() const;
+
+    unsigned int tiles_y() const;
+
+public:
+    /**
+     * @brief Constructor for DebugView object
+     *
+     * @param mode Quantity that is visualised
+     */
+    explicit DebugView(const Mode &mode = NONE);
+
+    /**
+     * @brief Get mode from value of [General] debugView
+     *
+     * @param name "overdraw", "shading", "shadow" or "tiles", everything else is NONE
+     *
+     * @return Mode
+     */
+    static Mode parse_mode(const std::string &name);
+
+    Mode getMode() const {
+        return mode;
+    }
+
+    /**
+     * @brief Clear all counts for an image of given size
+     *
+     * @param width Width of image
+     * @param height Height of image
+     */
+    void reset(const unsigned int width, const unsigned int height);
+
+    /**
+     * @brief Called once per triangle before its scanlines are rasterized
+     */
+    void begin_triangle() {
+        triangle++;
+    }
+
+    /**
+     * @brief Register scanline y of current triangle covering pixels [xl, xr)
+     */
+    void add_span(const unsigned int y, const unsigned int xl, const unsigned int xr);
+
+    /**
+     * @brief Register a depth-test of pixel (x, y)
+     */
+    void add_depth_test(const unsigned int x, const unsigned int y) {
+        if (mode == OVERDRAW) counts[x * height + y]++;
+    }
+
+    /**
+     * @brief Register the evaluation of amount lights for pixel (x, y)
+     */
+    void add_lights(const unsigned int x, const unsigned int y, const uint32_t amount) {
+        if (mode == SHADING_COST) counts[x * height + y] += amount;
+    }
+
+    /**
+     * @brief Register a lookup in the shadowMask of a light for pixel (x, y)
+     */
+    void add_shadow_lookup(const unsigned int x, const unsigned int y) {
+        if (mode == SHADOW_LOOKUPS) counts[x * height + y]++;
+    }
+
+    /**
+     * @brief Get highest count of image
+     *
+     * @return count as uint32_t
+     */
+    uint32_t max_count() const;
+
+    /**
+     * @brief Overwrite image with the counts, from black (0) over blue, green and yellow to red (max_count)
+     *
+     * @param image Image with size given to reset
+     */
+    void draw(img::EasyImage &image) const;
+
+    /**
+     * @brief Map value in [0, 1] to a colour of the heatmap
+     *
+     * @param x Value
+     *
+     * @return Color object
+     */
+    static img::Color heat_color(double x);
+};
+
+#endif //ENGINE_DEBUGVIEW_H
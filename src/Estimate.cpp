@@ -0,0 +1,428 @@
+//
+// Created by Pablo Deputter on 13/05/2021.
+//
+
+#include "Estimate.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include "Control.h"
+#include "easy_image.h"
+#include "Figure.h"
+#include "LSystem2D.h"
+#include "LSystemCache.h"
+#include "LSystemExpansion.h"
+#include "Platonic.h"
+#include "Utils.h"
+
+namespace {
+
+    uint64_t budget = 0;
+
+    /**
+     * @brief Add and multiply without overflowing, UINT64_MAX stands for an amount that does not fit
+     */
+    uint64_t add(const uint64_t a, const uint64_t b) {
+        return a > std::numeric_limits<uint64_t>::max() - b ? std::numeric_limits<uint64_t>::max() : a + b;
+    }
+
+    uint64_t multiply(const uint64_t a, const uint64_t b) {
+        return b != 0 && a > std::numeric_limits<uint64_t>::max() / b ? std::numeric_limits<uint64_t>::max() : a * b;
+    }
+
+    uint64_t power(const uint64_t a, const int b) {
+        uint64_t x = 1;
+        for (int i = 0; i < b; i++) x = multiply(x, a);
+        return x;
+    }
+
+    /**
+     * @brief Bytes of a point in a Points3D and of its projection
+     */
+    const uint64_t POINT_BYTES = 3 * sizeof(double) + 2 * sizeof(double);
+
+    /**
+     * @brief Size of the mesh of a figure
+     */
+    struct MeshSize {
+        uint64_t points = 0;
+        uint64_t triangles = 0;
+        /**
+         * @brief Point indexes of polygons that are not split in triangles, every one is the start of a drawn line
+         */
+        uint64_t indexes = 0;
+        uint64_t faces = 0;
+
+        uint64_t bytes() const {
+            return add(add(multiply(points, POINT_BYTES), multiply(triangles, sizeof(Triangle))),
+                       multiply(add(indexes, faces), sizeof(int)));
+        }
+    };
+
+    /**
+     * @brief Size of a generated mesh, polygons are counted as the triangles they are split in if filled is true
+     */
+    MeshSize mesh_size(const Figure &figure, const bool filled) {
+        MeshSize x;
+        x.points = figure.get_points().size();
+        x.triangles = figure.get_triangles().size();
+        for (unsigned int i = 0; i != figure.nr_faces(); i++) {
+            const unsigned int size = figure.get_face(i).size();
+            if (filled && size >= 3) x.triangles += size - 2;
+            else {
+                x.indexes += size;
+                x.faces++;
+            }
+        }
+        return x;
+    }
+
+    /**
+     * @brief Generate base mesh of a platonic solid, type without "Fractal" in front
+     */
+    bool platonic(const std::string &type, Figure &figure) {
+        if (type == "Cube" || type == "MengerSponge") figure = Platonic::cube();
+        else if (type == "Tetrahedron") figure = Platonic::tetrahedron();
+        else if (type == "Octahedron") figure = Platonic::octahedron();
+        else if (type == "Icosahedron") figure = Platonic::icosahedron();
+        else if (type == "Dodecahedron") figure = Platonic::dodecahedron();
+        else if (type == "BuckyBall") figure = Platonic::buckyBall();
+        else return false;
+        return true;
+    }
+
+    /**
+     * @brief Size of a sphere, cone, cylinder or torus with n and m as given to its generator
+     */
+    MeshSize round_size(const std::string &type, const uint64_t n, const uint64_t m, const bool filled) {
+        MeshSize x;
+        if (type == "Sphere") {
+            x.points = add(multiply(10, power(4, static_cast<int>(n))), 2);
+            x.triangles = multiply(20, power(4, static_cast<int>(n)));
+        }
+        else if (type == "Cone") {
+            x.points = n + 1;
+            x.triangles = n;
+        }
+        else if (type == "Cylinder") {
+            x.points = 2 * n;
+            if (filled) x.triangles = 2 * n + (n > 2 ? 2 * (n - 2) : 0);
+            else {
+                x.indexes = 4 * n + 2 * n;
+                x.faces = n + 2;
+            }
+        }
+        else {
+            x.points = n * m;
+            if (filled) x.triangles = 2 * n * m;
+            else {
+                x.indexes = 4 * n * m;
+                x.faces = n * m;
+            }
+        }
+        return x;
+    }
+
+    /**
+     * @brief Length of the string of a LSystem after every iteration
+     */
+    std::vector<uint64_t> symbols_per_iteration(const LParser::LSystem &l_system) {
+
+        const unsigned int iterations = l_system.get_nr_iterations();
+        const std::vector<uint64_t> lengths = LSystemExpansion::symbol_lengths(l_system, iterations);
+        std::vector<uint64_t> symbols;
+        for (unsigned int k = 0; k <= iterations; k++) {
+            uint64_t length = 0;
+            for (const char &i : l_system.get_initiator()) {
+                length = add(length, lengths[k * std::size_t(256) + static_cast<unsigned char>(i)]);
+            }
+            symbols.push_back(length);
+        }
+        return symbols;
+    }
+
+    Estimate::Item estimate_2DLSystem(const ini::Configuration &configuration, const bool stream) {
+
+        Estimate::Item item;
+        item.figure = "2DLSystem";
+        item.type = "2DLSystem";
+
+        uint64_t hash;
+        const LParser::LSystem2D l_system = LSystemCache::load_2D(
+                configuration["2DLSystem"]["inputfile"].as_string_or_die(), hash);
+        const unsigned int iterations = l_system.get_nr_iterations();
+        const std::string &initiator = l_system.get_initiator();
+        item.symbols = symbols_per_iteration(l_system);
+        item.lines = LSystemExpansion::expanded_count(l_system, initiator, iterations, LParser::LSystem::DRAW);
+
+        item.streamed = stream || configuration["General"]["streamLSystem"].as_bool_or_default(false);
+        if (item.streamed) {
+            // Only the stack of the turtle and the rules that are being walked are held
+            const uint64_t depth = LSystemExpansion::max_bracket_depth(l_system, initiator, iterations);
+            item.bytes = add(multiply(depth + 1, sizeof(Point2D) + sizeof(double)), multiply(iterations + 1, 64));
+            return item;
+        }
+
+        // Every line is a node of a Lines2D, memoized symbols hold at most one more copy of them
+        uint64_t line_bytes = sizeof(Line2D) + 2 * sizeof(void *);
+        if (configuration["General"]["memoizeLSystem"].as_bool_or_default(false) && LSystem_2D::memoizable(l_system)) {
+            line_bytes += 4 * sizeof(double);
+        }
+        item.points = 2 * item.lines;
+        item.bytes = multiply(item.lines, line_bytes);
+        return item;
+    }
+
+    bool is_round(const std::string &type) {
+        return type == "Sphere" || type == "Cone" || type == "Cylinder" || type == "Torus";
+    }
+
+    /**
+     * @brief Choose tessellation of every figure with lod = "auto" the way Control::generate_figures does
+     *
+     * The image is scaled to every figure that is not a line drawing. A fractal stands in with its base mesh, its copies
+     * lie inside it and keep its corners, so its bounds stay the same. Round primitives come from the MeshCache, the
+     * render takes the same meshes.
+     */
+    std::map<std::string, Control::Lod> choose_lods(const ini::Configuration &configuration, const bool filled) {
+
+        std::map<std::string, Control::Lod> lods;
+        const int nr_figures = configuration["General"]["nrFigures"].as_int_or_default(0);
+        auto is_lod = [&configuration](const std::string &figure_name) {
+            return is_round(configuration[figure_name]["type"].as_string_or_default(""))
+                   && configuration[figure_name]["lod"].as_string_or_default("fixed") == "auto";
+        };
+        bool any = false;
+        for (int i = 0; i < nr_figures && !any; i++) any = is_lod("Figure" + std::to_string(i));
+        if (!any) return lods;
+
+        // Figures with lod = auto, name, type and their coarse figure
+        struct AutoLod {
+            std::string name;
+            std::string type;
+            Figures3D::iterator figure;
+        };
+        std::vector<AutoLod> auto_lods;
+        Figures3D figures;
+        for (int i = 0; i < nr_figures; i++) {
+            const std::string figure_name = "Figure" + std::to_string(i);
+            const std::string type = configuration[figure_name]["type"].as_string_or_default("");
+            const std::string base_type = type.compare(0, 7, "Fractal") == 0 ? type.substr(7) : type;
+            const bool lod = is_lod(figure_name);
+            Figure figure;
+            if (lod) {
+                const int coarse = type == "Sphere" ? Platonic::COARSE_SPHERE_LEVEL : Platonic::COARSE_CIRCLE_SEGMENTS;
+                figure = Control::round_primitive(configuration, figure_name, type, coarse, coarse, filled);
+            }
+            else if (type == "Torus") {
+                figure = Control::round_primitive(
+                        configuration, figure_name, type,
+                        static_cast<int>(configuration[figure_name]["n"].as_double_or_die()),
+                        static_cast<int>(configuration[figure_name]["m"].as_double_or_die()), filled);
+            }
+            else if (is_round(type)) {
+                figure = Control::round_primitive(configuration, figure_name, type,
+                                                  configuration[figure_name]["n"].as_int_or_die(), 0, filled);
+            }
+            else if (!platonic(base_type, figure)) continue;
+
+            Matrix trans_matrix;
+            std::vector<double> origin;
+            Control::generate_transMatrix(trans_matrix, origin, configuration, figure_name);
+            figure.set_model(trans_matrix);
+            figures.push_back(figure);
+            if (lod) auto_lods.push_back(AutoLod{figure_name, type, std::prev(figures.end())});
+        }
+
+        const std::vector<double> eye = configuration["General"]["eye"].as_double_tuple_or_die();
+        const Matrix eye_matrix = Figure::eye_point_trans(Vector3D::point(eye[0], eye[1], eye[2]));
+        const double d = std::get<2>(Utils::prep_zbuffering(figures, eye_matrix,
+                                                            configuration["General"]["size"].as_int_or_die()));
+        for (const AutoLod &i : auto_lods) {
+            lods[i.name] = Control::choose_lod(configuration, i.name, i.type, *i.figure, eye_matrix, d);
+        }
+        return lods;
+    }
+
+    Estimate::Item estimate_figure(const ini::Configuration &configuration, const std::string &figure_name,
+                                   const bool filled, const bool stream,
+                                   const std::map<std::string, Control::Lod> &lods) {
+
+        Estimate::Item item;
+        item.figure = figure_name;
+        item.type = configuration[figure_name]["type"].as_string_or_default("");
+
+        const bool fractal = item.type.compare(0, 7, "Fractal") == 0 || item.type == "MengerSponge";
+        const std::string base_type = item.type.compare(0, 7, "Fractal") == 0 ? item.type.substr(7) : item.type;
+
+        MeshSize mesh;
+        Figure base;
+        if (platonic(base_type, base)) {
+            mesh = mesh_size(base, filled);
+        }
+        else if (is_round(base_type)) {
+            uint64_t n;
+            uint64_t m = 0;
+            // Tessellation of lod = "auto" as chosen by the render, see choose_lods
+            const std::map<std::string, Control::Lod>::const_iterator lod = lods.find(figure_name);
+            if (lod != lods.end()) {
+                n = static_cast<uint64_t>(lod->second.n);
+                m = static_cast<uint64_t>(lod->second.m);
+            }
+            else if (base_type == "Torus") {
+                n = static_cast<uint64_t>(std::max(0.0, configuration[figure_name]["n"].as_double_or_default(0)));
+                m = static_cast<uint64_t>(std::max(0.0, configuration[figure_name]["m"].as_double_or_default(0)));
+            }
+            else n = static_cast<uint64_t>(std::max(0, configuration[figure_name]["n"].as_int_or_default(0)));
+            mesh = round_size(base_type, n, m, filled);
+        }
+        else if (base_type == "3DLSystem") {
+            uint64_t hash;
+            const LParser::LSystem3D l_system = LSystemCache::load_3D(
+                    configuration[figure_name]["inputfile"].as_string_or_die(), hash);
+            const unsigned int iterations = l_system.get_nr_iterations();
+            const std::string &initiator = l_system.get_initiator();
+            item.symbols = symbols_per_iteration(l_system);
+            // Lines share their joints, a strip only starts over after a move or a pop
+            const uint64_t lines = LSystemExpansion::expanded_count(l_system, initiator, iterations,
+                                                                    LParser::LSystem::DRAW);
+            const uint64_t breaks = add(LSystemExpansion::expanded_count(l_system, initiator, iterations,
+                                                                         LParser::LSystem::MOVE),
+                                        LSystemExpansion::expanded_count(l_system, initiator, iterations,
+                                                                         LParser::LSystem::POP));
+            mesh.points = std::min(multiply(lines, 2), add(add(lines, breaks), 1));
+            mesh.indexes = multiply(lines, 2);
+            mesh.faces = lines;
+        }
+        else if (base_type == "LineDrawing") {
+            mesh.points = static_cast<uint64_t>(std::max(0,
+                                                         configuration[figure_name]["nrPoints"].as_int_or_default(0)));
+            mesh.faces = static_cast<uint64_t>(std::max(0,
+                                                        configuration[figure_name]["nrLines"].as_int_or_default(0)));
+            mesh.indexes = 2 * mesh.faces;
+        }
+
+        if (fractal) {
+            const bool menger_sponge = item.type == "MengerSponge";
+            int iterations = std::max(0, configuration[figure_name]["nrIterations"].as_int_or_default(0));
+            // Copies are anchored on the points of the base mesh before any sponge levels are merged into it
+            FractalRule rule;
+            rule.menger_sponge = menger_sponge;
+            rule.anchors = static_cast<unsigned int>(mesh.points);
+            // The last iterations of a filled sponge are merged into its base mesh, see Control::generate_figures
+            if (menger_sponge && filled) {
+                const int merged = std::min(iterations, Utils::MENGER_MERGED_LEVELS);
+                if (merged != 0) Utils::merge_menger_sponge(base, merged);
+                mesh = mesh_size(base, filled);
+                iterations -= merged;
+            }
+            const uint64_t children = Utils::nr_fractal_children(rule);
+            item.instances = power(children, iterations);
+
+            item.streamed = iterations > 0
+                            && (stream || configuration["General"]["streamFractals"].as_bool_or_default(false));
+            if (item.streamed) item.bytes = multiply(multiply(iterations, children), sizeof(Instance));
+            // The copies of the last two iterations are held at the same time
+            else item.bytes = multiply(add(item.instances, item.instances / std::max<uint64_t>(children, 1)),
+                                       sizeof(Instance));
+        }
+
+        item.points = mesh.points;
+        item.triangles = multiply(mesh.triangles, item.instances);
+        item.lines = multiply(filled ? mesh.indexes : add(mesh.indexes, multiply(mesh.triangles, 3)), item.instances);
+        item.bytes = add(item.bytes, mesh.bytes());
+        return item;
+    }
+}
+
+Estimate::Scene Estimate::estimate(const ini::Configuration &configuration, const bool stream) {
+
+    Scene scene;
+    const std::string type = configuration["General"]["type"].as_string_or_die();
+    const uint64_t size = static_cast<uint64_t>(std::max(0, configuration["General"]["size"].as_int_or_die()));
+
+    // Image, z-buffer and a shadow mask for every light
+    const uint64_t pixels = multiply(size, size);
+    scene.image_bytes = multiply(pixels, sizeof(img::Color));
+    const bool filled = type == "ZBuffering" || type == "LightedZBuffering" || type == "Texture";
+    if (filled || type == "ZBufferedWireframe") {
+        scene.image_bytes = add(scene.image_bytes, multiply(pixels, sizeof(double)));
+    }
+    if ((type == "LightedZBuffering" || type == "Texture")
+        && configuration["General"]["shadowEnabled"].as_bool_or_default(false)) {
+        const uint64_t mask = static_cast<uint64_t>(
+                std::max(0, configuration["General"]["shadowMask"].as_int_or_default(0)));
+        const uint64_t lights = static_cast<uint64_t>(
+                std::max(0, configuration["General"]["nrLights"].as_int_or_default(0)));
+        scene.image_bytes = add(scene.image_bytes, multiply(lights, multiply(multiply(mask, mask), sizeof(double))));
+    }
+
+    if (type == "2DLSystem") {
+        scene.items.push_back(estimate_2DLSystem(configuration, stream));
+    }
+    else {
+        const std::map<std::string, Control::Lod> lods = choose_lods(configuration, filled);
+        const int nr_figures = configuration["General"]["nrFigures"].as_int_or_default(0);
+        for (int i = 0; i < nr_figures; i++) {
+            scene.items.push_back(estimate_figure(configuration, "Figure" + std::to_string(i), filled, stream, lods));
+        }
+    }
+
+    scene.bytes = scene.image_bytes;
+    for (const Item &i : scene.items) scene.bytes = add(scene.bytes, i.bytes);
+    return scene;
+}
+
+Estimate::Scene Estimate::plan(const ini::Configuration &configuration) {
+
+    Scene scene = estimate(configuration, false);
+    scene.budget = budget;
+    if (budget == 0 || scene.bytes <= budget) return scene;
+
+    // Streamed L-systems and fractals only hold the state of the walk, the rest of the scene stays the same
+    scene = estimate(configuration, true);
+    scene.budget = budget;
+    scene.streamed = true;
+    scene.fits = scene.bytes <= budget;
+    return scene;
+}
+
+void Estimate::set_budget(const uint64_t x) {
+    budget = x;
+}
+
+uint64_t Estimate::get_budget() {
+    return budget;
+}
+
+void Estimate::write_json(std::ostream &out, const std::string &input_file, const Scene &scene) {
+
+    auto escape = [](const std::string &x) {
+        std::string escaped;
+        for (const char &i : x) {
+            if (i == '"' || i == '\\') escaped += '\\';
+            escaped += i;
+        }
+        return escaped;
+    };
+
+    out << "{\n";
+    out << "  \"input\": \"" << escape(input_file) << "\",\n";
+    out << "  \"image_bytes\": " << scene.image_bytes << ",\n";
+    out << "  \"peak_bytes\": " << scene.bytes << ",\n";
+    out << "  \"budget_bytes\": " << scene.budget << ",\n";
+    out << "  \"streamed\": " << (scene.streamed ? "true" : "false") << ",\n";
+    out << "  \"fits\": " << (scene.fits ? "true" : "false") << ",\n";
+    out << "  \"items\": [";
+    for (std::size_t i = 0; i != scene.items.size(); i++) {
+        const Item &item = scene.items[i];
+        out << (i != 0 ? ",\n" : "\n") << "    {\"figure\": \"" << escape(item.figure) << "\", \"type\": \""
+            << escape(item.type) << "\", \"symbols\": [";
+        for (std::size_t j = 0; j != item.symbols.size(); j++) out << (j != 0 ? ", " : "") << item.symbols[j];
+        out << "], \"instances\": " << item.instances << ", \"points\": " << item.points << ", \"lines\": "
+            << item.lines << ", \"triangles\": " << item.triangles << ", \"bytes\": " << item.bytes
+            << ", \"streamed\": " << (item.streamed ? "true" : "false") << "}";
+    }
+    out << (scene.items.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+}
@@ -0,0 +1,135 @@
+//
+// Created by Pablo Deputter on 13/05/2021.
+//
+
+#ifndef ENGINE_ESTIMATE_H
+#define ENGINE_ESTIMATE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ini_configuration.h"
+
+/**
+ * @brief Namespace holding the analysis of a scene before it is generated
+ *
+ * The amount of symbols of L-systems follows from their rule tables, the amount of copies of fractals and of triangles
+ * of primitives from their parameters, so the cost of a scene is known without generating it. Memory is estimated from
+ * the sizes of the structures that hold the geometry and is meant as an upper bound; stochastic L-systems are counted
+ * with their first rule. Figures with lod = "auto" get the tessellation the render chooses for them, which takes the
+ * coarse meshes of the primitives. If the estimate exceeds the budget the scene is generated with streamed L-systems
+ * and fractals, or refused if that does not fit either.
+ */
+namespace Estimate {
+
+    /**
+     * @brief Estimate of a single L-system or figure
+     */
+    struct Item {
+        /**
+         * @brief Name of the section in the .ini file
+         */
+        std::string figure;
+        std::string type;
+        /**
+         * @brief Length of the string after every iteration, L-systems only
+         */
+        std::vector<uint64_t> symbols;
+        /**
+         * @brief Copies that are drawn, the amount of fractal children to the power of the iterations
+         */
+        uint64_t instances = 1;
+        /**
+         * @brief Points of the mesh that is stored
+         */
+        uint64_t points = 0;
+        /**
+         * @brief Lines that are drawn, over every copy
+         */
+        uint64_t lines = 0;
+        /**
+         * @brief Triangles that are drawn, over every copy
+         */
+        uint64_t triangles = 0;
+        /**
+         * @brief Bytes held while the item is generated and drawn
+         */
+        uint64_t bytes = 0;
+        /**
+         * @brief Item is generated while it is drawn instead of being stored
+         */
+        bool streamed = false;
+    };
+
+    /**
+     * @brief Estimate of a scene
+     */
+    struct Scene {
+        std::vector<Item> items;
+        /**
+         * @brief Bytes of the image, z-buffer and shadow masks
+         */
+        uint64_t image_bytes = 0;
+        /**
+         * @brief Estimated peak memory of the render
+         */
+        uint64_t bytes = 0;
+        /**
+         * @brief Budget the scene was planned for, 0 if there is none
+         */
+        uint64_t budget = 0;
+        /**
+         * @brief L-systems and fractals are streamed to fit the budget
+         */
+        bool streamed = false;
+        /**
+         * @brief Scene fits the budget
+         */
+        bool fits = true;
+    };
+
+    /**
+     * @brief Estimate cost of a scene from its configuration alone
+     *
+     * @param configuration Contains .ini data
+     * @param stream Estimate as if every L-system and fractal that can be streamed is streamed
+     *
+     * @return Estimate of the scene, budget and fits are not set
+     */
+    Scene estimate(const ini::Configuration &configuration, const bool stream);
+
+    /**
+     * @brief Estimate a scene and check it against the budget, streaming is switched on if only that makes it fit
+     *
+     * @param configuration Contains .ini data
+     *
+     * @return Estimate of the scene as it will be generated
+     */
+    Scene plan(const ini::Configuration &configuration);
+
+    /**
+     * @brief Set memory budget of a single render, 0 disables the check
+     *
+     * @param bytes Budget in bytes
+     */
+    void set_budget(const uint64_t bytes);
+
+    /**
+     * @brief Get memory budget of a single render
+     *
+     * @return Budget in bytes, 0 if there is none
+     */
+    uint64_t get_budget();
+
+    /**
+     * @brief Write estimate of a scene as JSON
+     *
+     * @param out Stream to write to
+     * @param input_file Name of the .ini file
+     * @param scene Estimate of the scene
+     */
+    void write_json(std::ostream &out, const std::string &input_file, const Scene &scene);
+}
+
+#endif //ENGINE_ESTIMATE_H
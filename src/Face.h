@@ -9,7 +9,9 @@
 #include <vector>
 
 /**
- * @brief The Face class
+ * @brief The Face class, view on the indexes of a single polygon inside the flat index buffer of a Figure
+ *
+ * A Face does not own its indexes, it stays valid as long as no faces are added to the Figure it was taken from.
  */
 class Face {
 
@@ -17,32 +19,54 @@ private:
     /**
      * \brief Each index refers to a point in the "points" vector of a Figure-object
      */
-    std::vector<int> point_indexes;
+    const int *point_indexes;
+    /**
+     * \brief Amount of indexes of the polygon
+     */
+    unsigned int nr_indexes;
 public:
     /**
      * @brief Constructor for Face object
      *
-     * @param x std::vector of int
+     * @param x Pointer to first index of polygon
+     * @param size Amount of indexes
      */
-    explicit Face(const std::vector<int> &x) : point_indexes(x) {}
+    Face(const int *x, const unsigned int size) : point_indexes(x), nr_indexes(size) {}
 
     /**
-     * @brief Get point indexes
+     * @brief Get amount of indexes
      *
-     * @return point_indexes as const by reference
+     * @return size as unsigned int
      */
-    const std::vector<int> &get_point_indexes() const {
-        return point_indexes;
+    unsigned int size() const {
+        return nr_indexes;
     }
 
     /**
-     * @brief Correct indexes of Face by reducing every index by 1
+     * @brief Get point index i of polygon
+     *
+     * @return index as int
      */
-    void correct_indexes() {
-        for (int &i : point_indexes) {
-            i--;
-        }
+    int operator[](const unsigned int i) const {
+        return point_indexes[i];
+    }
+
+    const int *begin() const {
+        return point_indexes;
     }
+
+    const int *end() const {
+        return point_indexes + nr_indexes;
+    }
+};
+
+/**
+ * @brief Triangle of a Figure, each index refers to a point in the "points" vector of a Figure-object
+ */
+struct Triangle {
+    int a;
+    int b;
+    int c;
 };
 
 
@@ -3,25 +3,49 @@
 //
 
 #include "Figure.h"
+#include "ZBuffer.h"
 
 void Figure::add_point(const std::tuple<int, int, int> &x) {
-    points.emplace_back(Vector3D::point(std::get<0>(x), std::get<1>(x), std::get<2>(x)));
+    edit_mesh().points.emplace_back(Vector3D::point(std::get<0>(x), std::get<1>(x), std::get<2>(x)));
 }
 
 void Figure::add_point_double(const std::tuple<double, double, double> &x) {
-    points.emplace_back(Vector3D::point(std::get<0>(x), std::get<1>(x), std::get<2>(x)));
+    edit_mesh().points.emplace_back(Vector3D::point(std::get<0>(x), std::get<1>(x), std::get<2>(x)));
 }
 
 
 void Figure::correct_indexes() {
 
-    for (Face & i : faces) {
-        i.correct_indexes();
+    Mesh &m = edit_mesh();
+    for (int & i : m.face_indexes) {
+        i--;
+    }
+    for (Triangle & i : m.triangles) {
+        i.a--;
+        i.b--;
+        i.c--;
     }
 }
 
 void Figure::clear_faces() {
-    faces.clear();
+    Mesh &m = edit_mesh();
+    m.face_indexes.clear();
+    m.face_offsets.assign(1, 0);
+}
+
+void Figure::triangulate() {
+
+    if (nr_faces() == 0) return;
+
+    // A polygon of n points gives n - 2 triangles
+    Mesh &m = edit_mesh();
+    if (m.face_indexes.size() > 2 * nr_faces()) {
+        m.triangles.reserve(m.triangles.size() + m.face_indexes.size() - 2 * nr_faces());
+    }
+    for (unsigned int i = 0; i != nr_faces(); i++) {
+        ZBuffering::triangulate(get_face(i), m.triangles);
+    }
+    clear_faces();
 }
 
 Matrix Figure::scale_figure(const double &scaleFactor) {
@@ -81,9 +105,7 @@ Matrix Figure::translate(const Vector3D &vec) {
 void Figure::apply_transformation(const Matrix &x) {
 
     // Apply transformation
-    for (Vector3D & i : this->points) {
-        i *= x;
-    }
+    edit_mesh().points.transform(x);
 }
 
 std::tuple<double, double, double> Figure::to_polar(const Vector3D &point) {
@@ -118,25 +140,32 @@ Point2D Figure::do_projection(const Vector3D &point, const double &d) {
     return Point2D(x_, y_, point.z);
 }
 
-Lines2D Figure::do_projection() {
+Matrix Figure::instance_transformation(const std::size_t i, const Matrix &model_x) const {
 
-    std::vector<Point2D> array_points;
-    for (const Vector3D & i : this->points) {
-        // d is constant 1
-        array_points.emplace_back(this->do_projection(i, 1));
-    }
+    if (instances.empty()) return model_x;
+    return instance_transformation(instances[i], model_x);
+}
 
-    Lines2D array_lines;
-    // Traverse "faces" of figure
-    for (const Face & i : this->faces) {
+Matrix Figure::instance_transformation(const Instance &instance, const Matrix &model_x) {
 
-        for (unsigned int j = 0; j != i.get_point_indexes().size(); j++) {
+    // scale_figure(scale) * translate(x, y, z) * model_x without the full matrix products
+    Matrix x;
+    for (int j = 1; j <= 4; j++) {
+        x(1, j) = instance.scale * model_x(1, j);
+        x(2, j) = instance.scale * model_x(2, j);
+        x(3, j) = instance.scale * model_x(3, j);
+        x(4, j) = instance.x * model_x(1, j) + instance.y * model_x(2, j) + instance.z * model_x(3, j)
+                  + model_x(4, j);
+    }
+    return x;
+}
 
-            Point2D a = array_points[i.get_point_indexes()[j % i.get_point_indexes().size()]];
-            Point2D b = array_points[i.get_point_indexes()[(j + 1) % i.get_point_indexes().size()]];
+void Figure::project_bounds(const Matrix &x, Points3D &scratch, Transform::Bounds &bounds) const {
 
-            array_lines.emplace_back(a, b, this->ambientReflection.getColor());
-        }
+    const Matrix model_x = model * x;
+    for (std::size_t i = 0; i != nr_instances(); i++) {
+        // d is constant 1
+        scratch = mesh->points;
+        scratch.transform_bounds(instance_transformation(i, model_x), 1, bounds);
     }
-    return array_lines;
 }
@@ -6,26 +6,103 @@
 #define ENGINE_FIGURE_H
 
 
+#include <initializer_list>
 #include <list>
+#include <memory>
 #include <tuple>
 #include <cmath>
 #include <tgmath.h>
 #include "Face.h"
+#include "Points3D.h"
 #include "vector3d.h"
 #include "Color.h"
 #include "Line2D.h"
 
+/**
+ * @brief Copy of the base mesh of a Figure, a base point p is placed at p * scale + (x, y, z)
+ */
+struct Instance {
+    double scale;
+    double x;
+    double y;
+    double z;
+};
+
+/**
+ * @brief Rule of a fractal whose instances are generated while drawing instead of being stored
+ */
+struct FractalRule {
+    /**
+     * @brief Amount of times the fractal-algorithm is repeated, 0 if the figure is not a streamed fractal
+     */
+    int iterations = 0;
+    /**
+     * @brief Factor every copy is rescaled with
+     */
+    double scale = 1;
+    /**
+     * @brief Fractal is a MengerSponge
+     */
+    bool menger_sponge = false;
+    /**
+     * @brief Amount of points, from the start of the base mesh, the copies are scaled around
+     */
+    unsigned int anchors = 0;
+};
+
+/**
+ * @brief Geometry of a Figure, copies of a Figure share it until one of them changes it
+ */
+struct Mesh {
+    /**
+     * @brief points Points of the figure, stored as separate x, y and z arrays
+     */
+    Points3D points;
+    /**
+     * @brief face_indexes Point indexes of all polygons, stored one after the other
+     */
+    std::vector<int> face_indexes;
+    /**
+     * @brief face_offsets Polygon i uses face_indexes [face_offsets[i], face_offsets[i + 1])
+     */
+    std::vector<unsigned int> face_offsets = {0};
+    /**
+     * @brief triangles Faces that are triangles, filled by the generators of triangle meshes and by triangulation
+     */
+    std::vector<Triangle> triangles;
+
+    /**
+     * @brief Get memory used by the mesh
+     *
+     * @return Amount of bytes as std::size_t
+     */
+    std::size_t bytes() const {
+        return sizeof(Mesh) + 3 * sizeof(double) * points.size() + sizeof(int) * face_indexes.size()
+               + sizeof(unsigned int) * face_offsets.size() + sizeof(Triangle) * triangles.size();
+    }
+};
+
 class Figure {
 
 private:
     /**
-     * @brief points Vector of Vector3D objects
+     * @brief mesh Points and faces of the figure, shared with copies of the figure
      */
-    std::vector<Vector3D> points;
+    std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>();
     /**
-     * @brief faces Vector of Face objects
+     * @brief model Model transformation that is not applied to points yet, it is composed with the eye or light
+     * transformation and applied in a single pass
      */
-    std::vector<Face> faces;
+    Matrix model;
+    /**
+     * @brief instances Copies of the figure that are drawn, empty if the figure is drawn once as is
+     */
+    std::vector<Instance> instances;
+    /**
+     * @brief fractal_rule Rule the instances are generated with while drawing, used instead of instances when its
+     * amount of iterations is not 0
+     */
+    FractalRule fractal_rule;
     /**
      * @brief color cc::Color object with RGB-value between 0 & 1
      */
@@ -58,13 +135,146 @@ private:
      * @brief center Centre of the figure, used for textures
      */
     Vector3D center;
+
+    /**
+     * @brief Get mesh to be changed, it is copied first if other figures share it
+     */
+    Mesh &edit_mesh() {
+        if (mesh.use_count() > 1) mesh = std::make_shared<Mesh>(*mesh);
+        return *mesh;
+    }
 public:
-    std::vector<Vector3D> &get_points() {
-        return points;
+    /**
+     * @brief Get points to be changed, call the const version to only read them
+     */
+    Points3D &get_points() {
+        return edit_mesh().points;
     }
 
-    std::vector<Face> &get_faces() {
-        return faces;
+    const Points3D &get_points() const {
+        return mesh->points;
+    }
+
+    const Mesh &get_mesh() const {
+        return *mesh;
+    }
+
+    /**
+     * @brief Replace mesh by the mesh of x, both figures share it afterwards
+     */
+    void share_mesh(const Figure &x) {
+        mesh = x.mesh;
+    }
+
+    /**
+     * @brief Check if the mesh is shared with other figures
+     *
+     * @return true if shared
+     */
+    bool shares_mesh() const {
+        return mesh.use_count() > 1;
+    }
+
+    const Matrix &get_model() const {
+        return model;
+    }
+
+    void set_model(const Matrix &x) {
+        model = x;
+    }
+
+    std::vector<Instance> &get_instances() {
+        return instances;
+    }
+
+    const std::vector<Instance> &get_instances() const {
+        return instances;
+    }
+
+    const FractalRule &get_fractal_rule() const {
+        return fractal_rule;
+    }
+
+    void set_fractal_rule(const FractalRule &x) {
+        fractal_rule = x;
+    }
+
+    /**
+     * @brief Get amount of stored instances, a streamed fractal only stores its base mesh
+     *
+     * @return Amount as std::size_t, at least 1
+     */
+    std::size_t nr_instances() const {
+        return instances.empty() ? 1 : instances.size();
+    }
+
+    /**
+     * @brief Get transformation of instance i, composed with the transformation model * x
+     *
+     * @param i Index of instance
+     * @param model_x Result of get_model() * x
+     *
+     * @return Transformation matrix that brings the base points of instance i to the coordinates of x
+     */
+    Matrix instance_transformation(const std::size_t i, const Matrix &model_x) const;
+
+    /**
+     * @brief Get transformation of instance, composed with the transformation model_x
+     */
+    static Matrix instance_transformation(const Instance &instance, const Matrix &model_x);
+
+    /**
+     * @brief Get amount of polygons, triangles are not included
+     *
+     * @return Amount as unsigned int
+     */
+    unsigned int nr_faces() const {
+        return mesh->face_offsets.size() - 1;
+    }
+
+    /**
+     * @brief Get polygon i
+     *
+     * @return Face object, view on the index buffer
+     */
+    Face get_face(const unsigned int i) const {
+        return Face(mesh->face_indexes.data() + mesh->face_offsets[i],
+                    mesh->face_offsets[i + 1] - mesh->face_offsets[i]);
+    }
+
+    /**
+     * @brief Add polygon
+     *
+     * @param x Point indexes of polygon
+     */
+    void add_face(std::initializer_list<int> x) {
+        Mesh &m = edit_mesh();
+        m.face_indexes.insert(m.face_indexes.end(), x.begin(), x.end());
+        m.face_offsets.emplace_back(m.face_indexes.size());
+    }
+
+    void add_face(const std::vector<int> &x) {
+        Mesh &m = edit_mesh();
+        m.face_indexes.insert(m.face_indexes.end(), x.begin(), x.end());
+        m.face_offsets.emplace_back(m.face_indexes.size());
+    }
+
+    /**
+     * @brief Add triangle
+     */
+    void add_triangle(const int a, const int b, const int c) {
+        edit_mesh().triangles.push_back(Triangle{a, b, c});
+    }
+
+    /**
+     * @brief Get triangles to be changed, call the const version to only read them
+     */
+    std::vector<Triangle> &get_triangles() {
+        return edit_mesh().triangles;
+    }
+
+    const std::vector<Triangle> &get_triangles() const {
+        return mesh->triangles;
     }
 
     const cc::Color &get_color() const {
@@ -142,8 +352,16 @@ public:
 
     void correct_indexes();
 
+    /**
+     * @brief Remove all polygons, triangles are kept
+     */
     void clear_faces();
 
+    /**
+     * @brief Replace every polygon by a fan of triangles, a mesh without polygons stays shared
+     */
+    void triangulate();
+
     static Matrix scale_figure(const double &scaleFactor);
 
     static Matrix rotateX(const double &angle);
@@ -154,6 +372,9 @@ public:
 
     static Matrix translate(const Vector3D &vector);
 
+    /**
+     * @brief Apply x to the points directly, it is applied before the model transformation
+     */
     void apply_transformation(const Matrix &x);
 
     static std::tuple<double, double, double> to_polar(const Vector3D &x);
@@ -162,7 +383,17 @@ public:
 
     static Point2D do_projection(const Vector3D &point, const double &d);
 
-    Lines2D do_projection();
+    /**
+     * @brief Widen bounds with the projection on the plane z = -1 of every instance, transformed by model * x
+     *
+     * Every copy of a fractal lies inside the convex hull of its base mesh and the points of the base mesh are part
+     * of the fractal, so for a streamed fractal the projection of the base mesh gives the same bounds.
+     *
+     * @param x Eye transformation matrix
+     * @param scratch Buffer for the transformed points
+     * @param bounds Bounding box of projected points
+     */
+    void project_bounds(const Matrix &x, Points3D &scratch, Transform::Bounds &bounds) const;
 };
 
 typedef std::list<Figure> Figures3D;
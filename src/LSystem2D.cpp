@@ -3,81 +3,283 @@
 //
 
 #include "LSystem2D.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "LSystemExpansion.h"
+#include "LSystemIterator.h"
+#include "Stats.h"
+#include "Utils.h"
 
-std::string LSystem_2D::generate_string(const LParser::LSystem &l_system, int iter, std::string &l_system_string) {
+namespace {
+
+    /**
+     * @brief Line drawn by the turtle
+     */
+    struct Segment {
+        double x0;
+        double y0;
+        double x1;
+        double y1;
+    };
+
+    /**
+     * @brief Position and direction of the turtle
+     */
+    struct State {
+        double x = 0;
+        double y = 0;
+        double angle = 0;
+    };
 
-    // Base case of recursion
-    if (iter == 0) return l_system_string;
+    /**
+     * @brief Lines of a symbol expanded a given amount of iterations, drawn from (0, 0) facing angle 0, and the state
+     * the turtle is left in
+     */
+    struct Batch {
+        std::vector<Segment> segments;
+        State end;
+    };
 
-    // Make new string
-    std::string x;
+    /**
+     * @brief Turtle that draws every (symbol, iterations left) once and places copies of it afterwards
+     */
+    class MemoTurtle {
 
-    // Iterate over all char's
-    for (const char & i : l_system_string) {
-        if (i == '+' || i == '-' || i == '[' || i == ']' || i == '(' || i == ')') { // Ignore these char's
-            x += i;
-            continue;
+    private:
+        const LParser::LSystem &l_system;
+        /**
+         * @brief delta Angle of a turn in radians
+         */
+        double delta;
+        /**
+         * @brief batches Drawn symbols, index iterations * 256 + symbol
+         */
+        std::vector<std::unique_ptr<Batch>> batches;
+
+        /**
+         * @brief Get batch of symbol x expanded depth times, depth > 0
+         */
+        const Batch &get(const char x, const unsigned int depth) {
+
+            std::unique_ptr<Batch> &batch = batches[depth * std::size_t(256) + static_cast<unsigned char>(x)];
+            if (!batch) {
+                std::unique_ptr<Batch> drawn(new Batch());
+                std::vector<Segment> &segments = drawn->segments;
+                const LParser::LSystem::Symbol &symbol = l_system.get_symbol(x);
+                walk(symbol.replacement, symbol.replacement_length, depth - 1, drawn->end,
+                     [&segments](const Segment &i) { segments.push_back(i); });
+                batch = std::move(drawn);
+            }
+            return *batch;
         }
-        else if (l_system.get_stochastic()) {
-            x += l_system.get_replacement_stochastic(i);
-            continue;
+
+    public:
+        MemoTurtle(const LParser::LSystem &l_system, const unsigned int iterations)
+                : l_system(l_system), delta(l_system.get_angle() * M_PI / 180),
+                  batches((iterations + std::size_t(1)) * 256) {}
+
+        /**
+         * @brief Draw rule of which every symbol is expanded depth more times, starting from state, every line is
+         * passed to emit
+         */
+        template <typename Emit>
+        void walk(const char *rule, const std::size_t length, const unsigned int depth, State &state, Emit emit) {
+
+            std::vector<State> stack;
+            for (std::size_t i = 0; i != length; i++) {
+                const LParser::LSystem::Symbol &symbol = l_system.get_symbol(rule[i]);
+                switch (symbol.type) {
+                    case LParser::LSystem::TURN:
+                        if (rule[i] == '+') state.angle += delta;
+                        else if (rule[i] == '-') state.angle -= delta;
+                        break;
+                    case LParser::LSystem::PUSH:
+                        stack.push_back(state);
+                        break;
+                    case LParser::LSystem::POP:
+                        state = stack.back();
+                        stack.pop_back();
+                        break;
+                    case LParser::LSystem::DRAW:
+                    case LParser::LSystem::MOVE: {
+                        const double c = std::cos(state.angle);
+                        const double s = std::sin(state.angle);
+                        if (depth == 0 || !symbol.rewritten) {
+                            if (symbol.type == LParser::LSystem::DRAW) {
+                                emit(Segment{state.x, state.y, state.x + c, state.y + s});
+                            }
+                            state.x += c;
+                            state.y += s;
+                            break;
+                        }
+                        // Place the batch of the symbol at the current state of the turtle
+                        const Batch &batch = get(rule[i], depth);
+                        for (const Segment &j : batch.segments) {
+                            emit(Segment{state.x + c * j.x0 - s * j.y0, state.y + s * j.x0 + c * j.y0,
+                                         state.x + c * j.x1 - s * j.y1, state.y + s * j.x1 + c * j.y1});
+                        }
+                        state.x += c * batch.end.x - s * batch.end.y;
+                        state.y += s * batch.end.x + c * batch.end.y;
+                        state.angle += batch.end.angle;
+                        break;
+                    }
+                    case LParser::LSystem::IGNORED:
+                        break;
+                }
+            }
         }
-        // Find replacement for char
-        x += l_system.get_replacement(i);
-    }
-    // Enter recursion
-    return generate_string(l_system, iter - 1, x);
-}
+    };
 
-Lines2D LSystem_2D::drawLSystem(LParser::LSystem2D &l_system_2D, const cc::Color &color) {
+    /**
+     * @brief Walk every symbol of the expanded string with the turtle, every line is passed to emit
+     *
+     * @return Amount of symbols walked
+     */
+    template <typename Emit>
+    uint64_t walk(LParser::LSystem2D &l_system_2D, Emit emit) {
 
-    int iter = l_system_2D.get_nr_iterations();
-    std::string x = l_system_2D.get_initiator();
+        // Symbols are generated one at a time instead of expanding the full string first
+        LSystemIterator symbols(l_system_2D, l_system_2D.get_nr_iterations());
+        uint64_t nr_symbols = 0;
 
-    // Generate full string
-    std::string l_system_string = generate_string(l_system_2D, iter, x);
+        double angle = l_system_2D.get_starting_angle() * M_PI / 180;
 
-    double angle = l_system_2D.get_starting_angle() * M_PI / 180;
+        Point2D starting_position = Point2D(0.0, 0.0);
 
-    Point2D starting_position = Point2D(0.0, 0.0);
+        std::stack<std::pair<Point2D, double>> stack;
 
-    Lines2D l_system_lines;
+        char i;
+        const double delta = l_system_2D.get_angle() * M_PI / 180;
 
-    std::stack<std::pair<Point2D, double>> stack;
+        while (symbols.next(i)) {
+            nr_symbols++;
+            const LParser::LSystem::Symbol &symbol = l_system_2D.get_symbol(i);
+            switch (symbol.type) {
+                case LParser::LSystem::TURN:
+                    // Rotate left or right
+                    if (i == '+') angle += delta;
+                    else if (i == '-') angle -= delta;
+                    break;
+                case LParser::LSystem::PUSH:
+                    stack.push(std::make_pair(starting_position, angle));
+                    break;
+                case LParser::LSystem::POP:
+                    starting_position = stack.top().first;
+                    angle = stack.top().second;
+                    stack.pop();
+                    break;
+                case LParser::LSystem::DRAW:
+                case LParser::LSystem::MOVE: {
+                    // Move forward
+                    Point2D old_position = starting_position;
 
-    for (const char & i : l_system_string) {
-        // Rotate left
-        if (i == '+') {
-            angle += l_system_2D.get_angle() * M_PI / 180;
-        }
-            // Rotate right
-        else if (i == '-') {
-            angle -= l_system_2D.get_angle() * M_PI / 180;
-        }
+                    starting_position.setX(starting_position.getX() + std::cos(angle));
+                    starting_position.setY(starting_position.getY() + std::sin(angle));
 
-            // Push on stack
-        else if (i == '(' || i == '[') {
-            stack.push(std::make_pair(starting_position, angle));
-        }
-            // Pop the stack
-        else if (i == ')' || i == ']') {
-            starting_position = stack.top().first;
-            angle = stack.top().second;
-            stack.pop();
+                    // "Draw" line
+                    if (symbol.type == LParser::LSystem::DRAW) emit(old_position, starting_position);
+                    break;
+                }
+                case LParser::LSystem::IGNORED:
+                    break;
+            }
         }
-        else {
-            // Move forward
-            Point2D old_position = starting_position;
+        return nr_symbols;
+    }
+}
 
-            starting_position.setX(starting_position.getX() + std::cos(angle));
-            starting_position.setY(starting_position.getY() + std::sin(angle));
+bool LSystem_2D::memoizable(const LParser::LSystem &l_system) {
 
-            // "Draw" line
-            if (l_system_2D.draw(i)) {
-                Line2D y = Line2D(old_position, starting_position, color);
-                l_system_lines.emplace_back(y);
-            }
+    if (l_system.get_stochastic()) return false;
+
+    // A batch can only be placed as a whole if the brackets of every rule are balanced
+    for (const char &i : l_system.get_alphabet()) {
+        const LParser::LSystem::Symbol &symbol = l_system.get_symbol(i);
+        int depth = 0;
+        for (std::size_t j = 0; j != symbol.replacement_length && depth >= 0; j++) {
+            const LParser::LSystem::SymbolType type = l_system.get_symbol(symbol.replacement[j]).type;
+            if (type == LParser::LSystem::PUSH) depth++;
+            else if (type == LParser::LSystem::POP) depth--;
         }
+        if (depth != 0) return false;
     }
+    return true;
+}
+
+std::string LSystem_2D::generate_string(const LParser::LSystem &l_system, int iter, std::string &l_system_string) {
+
+    // Expanded over every thread, fails before allocating if the string would not fit
+    return LSystemExpansion::expand(l_system, l_system_string, static_cast<unsigned int>(iter));
+}
+
+Lines2D LSystem_2D::drawLSystem(LParser::LSystem2D &l_system_2D, const cc::Color &color, const bool memoize) {
+
+    if (memoize && memoizable(l_system_2D)) return drawLSystem_memoized(l_system_2D, color);
+    return drawLSystem_walk(l_system_2D, color);
+}
+
+Lines2D LSystem_2D::drawLSystem_memoized(LParser::LSystem2D &l_system_2D, const cc::Color &color) {
+
+    const unsigned int iterations = l_system_2D.get_nr_iterations();
+    const std::string &initiator = l_system_2D.get_initiator();
+    Stats::counters().lsystem_symbols += LSystemExpansion::expanded_length(l_system_2D, initiator, iterations);
+
+    State state;
+    state.angle = l_system_2D.get_starting_angle() * M_PI / 180;
+
+    // Lines of the initiator go straight to the result, only the batches of the symbols below it are kept
+    Lines2D l_system_lines;
+    MemoTurtle turtle(l_system_2D, iterations);
+    turtle.walk(initiator.data(), initiator.size(), iterations, state, [&](const Segment &i) {
+        l_system_lines.emplace_back(Point2D(i.x0, i.y0), Point2D(i.x1, i.y1), color);
+    });
     return l_system_lines;
 }
+
+Lines2D LSystem_2D::drawLSystem_walk(LParser::LSystem2D &l_system_2D, const cc::Color &color) {
+
+    Lines2D l_system_lines;
+    Stats::counters().lsystem_symbols += walk(l_system_2D, [&](const Point2D &a, const Point2D &b) {
+        l_system_lines.emplace_back(a, b, color);
+    });
+    return l_system_lines;
+}
+
+void LSystem_2D::drawLSystem_streamed(LParser::LSystem2D &l_system_2D, const cc::Color &color, const int &size,
+                                      img::EasyImage &image) {
+
+    // First pass only keeps the bounds of the lines, the same as Line2D::Line2D_findMax
+    bool empty = true;
+    double x = 0;
+    double y = 0;
+    double X = 0;
+    double Y = 0;
+    Stats::counters().lsystem_symbols += walk(l_system_2D, [&](const Point2D &a, const Point2D &b) {
+        if (empty) {
+            x = X = a.getX();
+            y = Y = a.getY();
+            empty = false;
+        }
+        for (const Point2D *i : {&a, &b}) {
+            x = std::min(x, i->getX());
+            y = std::min(y, i->getY());
+            X = std::max(X, i->getX());
+            Y = std::max(Y, i->getY());
+        }
+    });
+    if (empty) return;
+
+    // Second pass walks the same symbols again, the seed of stochastic LSystems gives the same choices, and draws every
+    // line as soon as the turtle makes it
+    const Line2D::Fit fit = Line2D::fit(x, y, X, Y, size);
+    image.image_resize(static_cast<int>(std::round(fit.image_x)), static_cast<int>(std::round(fit.image_y)));
+    const img::Color line_color = Utils::saturate_color(color);
+    auto pixel = [&fit](const double p, const double dp) {
+        return static_cast<int>(std::round(p * fit.d + dp));
+    };
+    walk(l_system_2D, [&](const Point2D &a, const Point2D &b) {
+        image.draw_line(pixel(a.getX(), fit.dx), pixel(a.getY(), fit.dy), pixel(b.getX(), fit.dx),
+                        pixel(b.getY(), fit.dy), line_color);
+    });
+}
@@ -12,11 +12,11 @@
 namespace LSystem_2D {
 
     /**
-    * @brief Generate LSystem string recursively
+    * @brief Generate full LSystem string, see LSystemExpansion::expand
     *
     * @param l_system LSystem containing all the data that is needed to replace char's in the string by replacement rules
     * @param iter Amount of iterations that generate_string needs to be called
-    * @param l_system_string Original string containing the initiator of the LSystem, will be passed trough recursively
+    * @param l_system_string Original string containing the initiator of the LSystem
     */
     std::string generate_string(const LParser::LSystem &l_system, int iter, std::string &l_system_string);
 
@@ -25,8 +25,54 @@ namespace LSystem_2D {
      *
      * @param l_system_2D LSystem containing all the data that is needed to replace char's in the string by replacement rules
      * @param color Color of lines that need to be drawn
+     * @param memoize Use drawLSystem_memoized if the LSystem is memoizable, its lines can differ slightly from the
+     * default ones
      */
-    Lines2D drawLSystem(LParser::LSystem2D &l_system_2D, const cc::Color &color);
+    Lines2D drawLSystem(LParser::LSystem2D &l_system_2D, const cc::Color &color, const bool memoize = false);
+
+    /**
+     * @brief Check if the lines of every symbol can be drawn once and placed again for every next occurrence, true
+     * for deterministic LSystems of which every rule has balanced brackets
+     *
+     * @param l_system LSystem to be checked
+     *
+     * @return true if drawLSystem_memoized can be used
+     */
+    bool memoizable(const LParser::LSystem &l_system);
+
+    /**
+     * @brief Converts a LSystem to lines by walking every symbol of the expanded string
+     *
+     * @param l_system_2D LSystem to be drawn
+     * @param color Color of lines that need to be drawn
+     */
+    Lines2D drawLSystem_walk(LParser::LSystem2D &l_system_2D, const cc::Color &color);
+
+    /**
+     * @brief Converts a memoizable LSystem to lines, the lines of a symbol with a given amount of iterations left are
+     * drawn once and copied with a rotation and translation for every next occurrence, so the cost follows the amount
+     * of lines instead of the amount of symbols
+     *
+     * Copies are rotated as a whole instead of walked a step at a time, so rounding differs from drawLSystem_walk.
+     * For angles that are not a multiple of 90 degrees lines end up a tiny fraction of a unit off, which can move a
+     * rounded pixel along edges of the image.
+     *
+     * @param l_system_2D LSystem to be drawn
+     * @param color Color of lines that need to be drawn
+     */
+    Lines2D drawLSystem_memoized(LParser::LSystem2D &l_system_2D, const cc::Color &color);
+
+    /**
+     * @brief Draws a LSystem straight on image without keeping its lines, the turtle walks the symbols twice, once to
+     * find the bounds of the lines and once to draw them, so memory does not depend on the amount of lines
+     *
+     * @param l_system_2D LSystem to be drawn
+     * @param color Color of lines that need to be drawn
+     * @param size Maximum amount of pixels of image, see Line2D::draw2DLines
+     * @param image Image that is resized and drawn on
+     */
+    void drawLSystem_streamed(LParser::LSystem2D &l_system_2D, const cc::Color &color, const int &size,
+                              img::EasyImage &image);
 };
 
 #endif //ENGINE_LSYSTEM2D_H
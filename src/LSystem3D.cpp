@@ -3,140 +3,151 @@
 //
 
 #include "LSystem3D.h"
+#include "LSystemExpansion.h"
+#include "LSystemIterator.h"
+#include "Stats.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <vector>
 
-Figure LSystem_3D::drawLSystem(LParser::LSystem3D &l_system_3D) {
+namespace {
 
-    unsigned int iter = l_system_3D.get_nr_iterations();
-    std::string x = l_system_3D.get_initiator();
+    /**
+     * @brief Rotation of the frame of the turtle, row i holds the new i-th axis as a combination of H, L and U
+     */
+    struct Rotation {
+        double m[3][3];
+    };
 
-    // Generate full string
-    std::string l_system_string = generate_string(l_system_3D, iter, x);
+    /**
+     * @brief Position of the turtle and its frame, rows H (direction), L (left) and U (up), point is the index of the
+     * position in the points of the figure, -1 if no line ends there yet
+     */
+    struct Turtle {
+        double position[3];
+        double frame[3][3];
+        int point;
+    };
 
-    // Hold lines in 3D-environment
-    Figure l_system;
+    /**
+     * @brief Rotations of the turtle in the order + - ^ & \ / |
+     */
+    enum RotationIndex {LEFT, RIGHT, PITCH_UP, PITCH_DOWN, ROLL_LEFT, ROLL_RIGHT, TURN_AROUND, NR_ROTATIONS};
+
+    /**
+     * @brief Get index of the rotation of symbol x, NR_ROTATIONS if x does not rotate the turtle
+     */
+    int rotation_index(const char x) {
+        switch (x) {
+            case '+': return LEFT;
+            case '-': return RIGHT;
+            case '^': return PITCH_UP;
+            case '&': return PITCH_DOWN;
+            case '\\': return ROLL_LEFT;
+            case '/': return ROLL_RIGHT;
+            case '|': return TURN_AROUND;
+            default: return NR_ROTATIONS;
+        }
+    }
 
-    // Holds current position (x,y,z)
-    Vector3D current_position = Vector3D::point(0, 0, 0);
+    /**
+     * @brief Rotate frame of the turtle
+     */
+    void rotate(Turtle &turtle, const Rotation &rotation) {
 
-    // Holds current angle
-    double current_angle = l_system_3D.get_angle() * M_PI / 180;
+        double frame[3][3];
+        for (int i = 0; i != 3; i++) {
+            for (int j = 0; j != 3; j++) {
+                frame[i][j] = rotation.m[i][0] * turtle.frame[0][j] + rotation.m[i][1] * turtle.frame[1][j]
+                              + rotation.m[i][2] * turtle.frame[2][j];
+            }
+        }
+        std::memcpy(turtle.frame, frame, sizeof(frame));
+    }
+}
 
-    // Current direction - initialized on x-axis
-    Vector3D H = Vector3D::vector(1, 0, 0);
-    // Perpendicular to H-vector, initialized on y-axis
-    Vector3D L = Vector3D::vector(0, 1, 0);
-    // Upwards direction - initialized on z-axis
-    Vector3D U = Vector3D::vector(0, 0, 1);
+Figure LSystem_3D::drawLSystem(LParser::LSystem3D &l_system_3D) {
 
-    // Needed to store data in stack
-    struct Data {
-    public:
-        Vector3D current_position;
-        Vector3D H;
-        Vector3D L;
-        Vector3D U;
+    const unsigned int iterations = l_system_3D.get_nr_iterations();
 
-    public:
-        Data(const Vector3D &currentPosition, const Vector3D &h, const Vector3D &l, const Vector3D &u)
-                : current_position(currentPosition), H(h), L(l), U(u) {}
+    // Symbols are generated one at a time instead of expanding the full string first
+    LSystemIterator symbols(l_system_3D, iterations);
+    uint64_t nr_symbols = 0;
 
-        virtual ~Data() = default;
+    // Hold lines in 3D-environment
+    Figure l_system;
+    Points3D &points = l_system.get_points();
+
+    // Every turn uses the same angle, so the rotations are only built once
+    const double angle = l_system_3D.get_angle() * M_PI / 180;
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    const Rotation rotations[NR_ROTATIONS] = {
+            {{{c, s, 0}, {-s, c, 0}, {0, 0, 1}}},
+            {{{c, -s, 0}, {s, c, 0}, {0, 0, 1}}},
+            {{{c, 0, s}, {0, 1, 0}, {-s, 0, c}}},
+            {{{c, 0, -s}, {0, 1, 0}, {s, 0, c}}},
+            {{{1, 0, 0}, {0, c, -s}, {0, s, c}}},
+            {{{1, 0, 0}, {0, c, s}, {0, -s, c}}},
+            {{{-1, 0, 0}, {0, -1, 0}, {0, 0, 1}}}
     };
 
-    std::stack<Data> stack_data;
-
-    for (const char & i : l_system_string) {
-        if (i == '+') {
-            Vector3D H_ = H * cos(current_angle) + L * sin(current_angle);
-            Vector3D L_ = -H * sin(current_angle) + L * cos(current_angle);
-            H = H_;
-            L = L_;
-        }
-        else if (i == '-') {
-            Vector3D H_ = H * cos(-current_angle) + L * sin(-current_angle);
-            Vector3D L_ =  -H * sin(-current_angle) + L * cos(-current_angle);
-            H = H_;
-            L = L_;
-        }
-        else if (i == '^') {
-            Vector3D H_ = H * cos(current_angle) + U * sin(current_angle);
-            Vector3D U_= -H * sin(current_angle) + U * cos(current_angle);
-            H = H_;
-            U = U_;
-        }
-        else if (i == '&') {
-            Vector3D H_ = H * cos(-current_angle) + U * sin(-current_angle);
-            Vector3D U_ = -H * sin(-current_angle) + U * cos(-current_angle);
-            H = H_;
-            U = U_;
-        }
-        else if (i == '\\') {
-            Vector3D L_ = L*cos(current_angle) - U*sin(current_angle);
-            Vector3D U_ = L*sin(current_angle) + U*cos(current_angle);
-            L = L_;
-            U = U_;
-        }
-        else if (i == '/') {
-            Vector3D L_ = L * cos(-current_angle) - U * sin(-current_angle);
-            Vector3D U_ = L * sin(-current_angle) + U * cos(-current_angle);
-            L = L_;
-            U = U_;
-        }
-        else if (i == '|') {
-            H = -H;
-            L = -L;
-        }
-        else if (i == '(') {
-            // Push data on the stack
-            stack_data.push(Data(current_position, H, L, U));
-        }
-        else if (i == ')') {
-            // Retrieve data from stack and pop last added element (LIFO)
-            current_position = stack_data.top().current_position;
-            H = stack_data.top().H;
-            L = stack_data.top().L;
-            U = stack_data.top().U;
-            // Pop data from stack
-            stack_data.pop();
-        }
-        else {
-            Vector3D new_position = current_position;
-            current_position = current_position + H;
-
-            if (l_system_3D.draw(i)) {
-                // "Draw" line from old position to new position
-                l_system.get_points().emplace_back(new_position);
-                l_system.get_points().emplace_back(current_position);
-                // Add to faces
-                l_system.get_faces().emplace_back(Face({int(l_system.get_points().size() - 1),
-                                                   int(l_system.get_points().size() - 2)}));
-                continue;
+    // Starts in the origin facing the x-axis, with L on the y-axis and U on the z-axis
+    Turtle turtle = {{0, 0, 0}, {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, -1};
+
+    // Deepest nesting of brackets is known up front, so the stack never grows while drawing
+    std::vector<Turtle> stack;
+    stack.reserve(static_cast<std::size_t>(std::min<uint64_t>(
+            LSystemExpansion::max_bracket_depth(l_system_3D, l_system_3D.get_initiator(), iterations), 1 << 20)));
+
+    char i;
+    while (symbols.next(i)) {
+        nr_symbols++;
+        const LParser::LSystem::Symbol &symbol = l_system_3D.get_symbol(i);
+        switch (symbol.type) {
+            case LParser::LSystem::TURN: {
+                const int rotation = rotation_index(i);
+                if (rotation != NR_ROTATIONS) rotate(turtle, rotations[rotation]);
+                break;
+            }
+            case LParser::LSystem::PUSH:
+                stack.push_back(turtle);
+                break;
+            case LParser::LSystem::POP:
+                // Retrieve data from stack and pop last added element (LIFO)
+                turtle = stack.back();
+                stack.pop_back();
+                break;
+            case LParser::LSystem::DRAW:
+            case LParser::LSystem::MOVE: {
+                // Lines form strips, a line starts at the point where the previous one ended and a strip only breaks
+                // when the turtle moves without drawing, after a pop it continues from the point of the push
+                if (symbol.type == LParser::LSystem::DRAW && turtle.point == -1) {
+                    turtle.point = static_cast<int>(points.size());
+                    points.emplace_back(Vector3D::point(turtle.position[0], turtle.position[1], turtle.position[2]));
+                }
+                for (int j = 0; j != 3; j++) turtle.position[j] += turtle.frame[0][j];
+
+                if (symbol.type == LParser::LSystem::DRAW) {
+                    // "Draw" line from old position to new position
+                    points.emplace_back(Vector3D::point(turtle.position[0], turtle.position[1], turtle.position[2]));
+                    l_system.add_face({static_cast<int>(points.size() - 1), turtle.point});
+                    turtle.point = static_cast<int>(points.size() - 1);
+                }
+                else turtle.point = -1;
+                break;
             }
+            case LParser::LSystem::IGNORED:
+                break;
         }
     }
+    Stats::counters().lsystem_symbols += nr_symbols;
     return l_system;
 }
 
 std::string LSystem_3D::generate_string(const LParser::LSystem &l_system, int iter, std::string &l_system_string) {
 
-
-    // Base case of recursion
-    if (iter == 0) return l_system_string;
-
-    // Make new string
-    std::string x;
-
-    // Iterate over all char's
-    for (const char & i : l_system_string) {
-        if (i == '+' || i == '-' || i == '[' || i == ']' || i == '(' || i == ')' ||
-            i == '&' || i == '\\' || i == '/' || i == '|' || i == '^' ) { // Ignore these char's
-            x += i;
-            continue;
-        }
-        // Find replacement for char
-        x += l_system.get_replacement(i);
-    }
-    // Enter recursion
-    return generate_string(l_system, iter - 1, x);
+    // Expanded over every thread, fails before allocating if the string would not fit
+    return LSystemExpansion::expand(l_system, l_system_string, static_cast<unsigned int>(iter));
 }
@@ -18,11 +18,11 @@ namespace LSystem_3D {
     Figure drawLSystem(LParser::LSystem3D &l_system_3D);
 
     /**
-    * \brief            Generate LSystem string recursively
+    * \brief            Generate full LSystem string, see LSystemExpansion::expand
     *
     * \param l_system 	LSystem containing all the data that is needed to replace char's in the string by replacement rules
     * \param iter       Amount of iterations that generate_string needs to be called
-    * \param l_system_string Original string containing the initiator of the LSystem, will be passed trough recursively
+    * \param l_system_string Original string containing the initiator of the LSystem
     */
     std::string generate_string(const LParser::LSystem &l_system, int iter, std::string &l_system_string);
 
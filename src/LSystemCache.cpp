@@ -0,0 +1,282 @@
+//
+// Created by Pablo Deputter on 12/05/2021.
+//
+
+#include "LSystemCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include "LSystem2D.h"
+#include "LSystem3D.h"
+#include "LSystemExpansion.h"
+#include "MeshCache.h"
+#include "Stats.h"
+
+namespace {
+
+    /**
+     * @brief First bytes of every cache file, the last one is the version of the format
+     */
+    const char MAGIC[4] = {'L', 'S', 'C', '1'};
+
+    std::unordered_map<uint64_t, LParser::LSystem2D> systems_2D;
+    std::unordered_map<uint64_t, LParser::LSystem3D> systems_3D;
+    /**
+     * @brief Keys of 2D lines that were asked for before
+     */
+    std::unordered_set<std::string> requested_2D;
+    std::string directory;
+
+    /**
+     * @brief FNV-1a hash of x
+     */
+    uint64_t hash_of(const std::string &x) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (const char &i : x) {
+            hash = (hash ^ static_cast<unsigned char>(i)) * 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    std::string read_content(const std::string &file_name) {
+        std::ifstream input_stream(file_name, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(input_stream), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * @brief Parse content of a file once, systems holds the parsed LSystem of every hash
+     */
+    template <typename LSystem>
+    LSystem load(std::unordered_map<uint64_t, LSystem> &systems, const std::string &file_name, uint64_t &hash) {
+
+        const std::string content = read_content(file_name);
+        hash = hash_of(content);
+        typename std::unordered_map<uint64_t, LSystem>::iterator i = systems.find(hash);
+        if (i == systems.end()) {
+            LSystem l_system;
+            std::istringstream input_stream(content);
+            input_stream >> l_system;
+            i = systems.emplace(hash, l_system).first;
+        }
+        return i->second;
+    }
+
+    std::string key(const char *type, const uint64_t hash, const unsigned int iterations) {
+        char x[64];
+        std::snprintf(x, sizeof(x), "%s %016llx %u", type, static_cast<unsigned long long>(hash), iterations);
+        return x;
+    }
+
+    std::string file_of(const std::string &key) {
+        std::string name = key;
+        for (char &i : name) if (i == ' ') i = '-';
+        return directory + "/" + name + ".bin";
+    }
+
+    template <typename T>
+    void write_value(std::ostream &out, const T &x) {
+        out.write(reinterpret_cast<const char *>(&x), sizeof(T));
+    }
+
+    template <typename T>
+    bool read_value(std::istream &in, T &x) {
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(&x), sizeof(T)));
+    }
+
+    template <typename T>
+    bool read_array(std::istream &in, std::vector<T> &x, const uint64_t size) {
+        x.resize(static_cast<std::size_t>(size));
+        return size == 0 || static_cast<bool>(in.read(reinterpret_cast<char *>(x.data()), sizeof(T) * size));
+    }
+
+    /**
+     * @brief Write lines of figure to file, in native byte order: magic, hash, iterations, dimensions, amount of points,
+     * amount of indexes, x-, y- and if dimensions is 3 z-coordinates and the two point indexes of every line
+     *
+     * The file is written next to its final name first, so a render that reads it never sees half of it.
+     */
+    void write_lines(const std::string &file_name, const uint64_t hash, const uint32_t iterations,
+                     const uint32_t dimensions, const Figure &figure) {
+
+        const Mesh &mesh = figure.get_mesh();
+        const std::string temporary = file_name + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary);
+            out.write(MAGIC, sizeof(MAGIC));
+            write_value(out, hash);
+            write_value(out, iterations);
+            write_value(out, dimensions);
+            write_value(out, static_cast<uint64_t>(mesh.points.size()));
+            write_value(out, static_cast<uint64_t>(mesh.face_indexes.size()));
+            const std::size_t bytes = sizeof(double) * mesh.points.size();
+            out.write(reinterpret_cast<const char *>(mesh.points.x_data()), bytes);
+            out.write(reinterpret_cast<const char *>(mesh.points.y_data()), bytes);
+            if (dimensions == 3) out.write(reinterpret_cast<const char *>(mesh.points.z_data()), bytes);
+            out.write(reinterpret_cast<const char *>(mesh.face_indexes.data()), sizeof(int) * mesh.face_indexes.size());
+            if (!out) {
+                out.close();
+                std::remove(temporary.c_str());
+                return;
+            }
+        }
+        std::rename(temporary.c_str(), file_name.c_str());
+    }
+
+    /**
+     * @brief Read lines written by write_lines, false if the file is missing, cut short or of another L-system
+     */
+    bool read_lines(const std::string &file_name, const uint64_t hash, const uint32_t iterations,
+                    const uint32_t dimensions, Figure &figure) {
+
+        std::ifstream in(file_name, std::ios::binary);
+        char magic[sizeof(MAGIC)];
+        uint64_t file_hash;
+        uint32_t file_iterations;
+        uint32_t file_dimensions;
+        uint64_t nr_points;
+        uint64_t nr_indexes;
+        if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC)
+            || !read_value(in, file_hash) || !read_value(in, file_iterations) || !read_value(in, file_dimensions)
+            || !read_value(in, nr_points) || !read_value(in, nr_indexes)) return false;
+        if (file_hash != hash || file_iterations != iterations || file_dimensions != dimensions
+            || nr_indexes % 2 != 0) return false;
+
+        // Sizes are checked against the file before anything is allocated
+        const std::streampos header = in.tellg();
+        in.seekg(0, std::ios::end);
+        const uint64_t remaining = static_cast<uint64_t>(in.tellg() - header);
+        in.seekg(header);
+        if (nr_points > remaining || nr_indexes > remaining
+            || sizeof(double) * dimensions * nr_points + sizeof(int) * nr_indexes != remaining) return false;
+
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::vector<double> zs(static_cast<std::size_t>(dimensions == 3 ? 0 : nr_points), 0.0);
+        std::vector<int> indexes;
+        if (!read_array(in, xs, nr_points) || !read_array(in, ys, nr_points)
+            || (dimensions == 3 && !read_array(in, zs, nr_points)) || !read_array(in, indexes, nr_indexes)) {
+            return false;
+        }
+        for (const int &i : indexes) {
+            if (i < 0 || static_cast<uint64_t>(i) >= nr_points) return false;
+        }
+
+        Points3D &points = figure.get_points();
+        points.reserve(xs.size());
+        for (std::size_t i = 0; i != xs.size(); i++) points.emplace_back(Vector3D::point(xs[i], ys[i], zs[i]));
+        for (std::size_t i = 0; i != indexes.size(); i += 2) figure.add_face({indexes[i], indexes[i + 1]});
+        return true;
+    }
+
+    /**
+     * @brief Get figure holding the lines of key from memory, from the cache directory or from draw, in that order
+     *
+     * A hit counts the symbols of l_system as walked, so Stats do not depend on whether the lines were cached.
+     */
+    Figure cached(const std::string &key, const LParser::LSystem &l_system, const uint64_t hash,
+                  const uint32_t dimensions, const std::function<Figure()> &draw) {
+
+        const uint32_t iterations = l_system.get_nr_iterations();
+        bool hit = true;
+        Figure figure = MeshCache::get(key, [&]() {
+            Figure x;
+            const std::string file_name = directory.empty() ? std::string() : file_of(key);
+            if (!file_name.empty() && read_lines(file_name, hash, iterations, dimensions, x)) return x;
+            hit = false;
+            x = draw();
+            if (!file_name.empty()) write_lines(file_name, hash, iterations, dimensions, x);
+            return x;
+        });
+        if (hit) {
+            Stats::counters().lsystem_cache_hits++;
+            Stats::counters().lsystem_symbols += LSystemExpansion::expanded_length(l_system, l_system.get_initiator(),
+                                                                                   iterations);
+        }
+        else Stats::counters().lsystem_cache_misses++;
+        return figure;
+    }
+}
+
+LParser::LSystem2D LSystemCache::load_2D(const std::string &file_name, uint64_t &hash) {
+    return load(systems_2D, file_name, hash);
+}
+
+LParser::LSystem3D LSystemCache::load_3D(const std::string &file_name, uint64_t &hash) {
+    return load(systems_3D, file_name, hash);
+}
+
+Lines2D LSystemCache::draw_2D(LParser::LSystem2D &l_system_2D, const uint64_t hash, const cc::Color &color,
+                              const bool memoize) {
+
+    if (l_system_2D.get_stochastic()) return LSystem_2D::drawLSystem(l_system_2D, color, memoize);
+
+    // Memoized lines differ slightly from walked ones, so they are kept under their own key
+    const bool memoized = memoize && LSystem_2D::memoizable(l_system_2D);
+    const std::string lines_key = key(memoized ? "2DLSystemMemoized" : "2DLSystem", hash,
+                                      l_system_2D.get_nr_iterations());
+
+    // Without a directory the copy of the lines only pays off once they are asked for again, and only if the cache
+    // can hold it: every line takes at most two points, two indexes and a face offset
+    if (directory.empty()) {
+        const bool repeated = !requested_2D.insert(lines_key).second;
+        const uint64_t lines = LSystemExpansion::expanded_count(l_system_2D, l_system_2D.get_initiator(),
+                                                                l_system_2D.get_nr_iterations(),
+                                                                LParser::LSystem::DRAW);
+        const uint64_t line_bytes = 2 * 3 * sizeof(double) + 2 * sizeof(int) + sizeof(unsigned int);
+        if (!repeated || lines > MeshCache::get_capacity() / line_bytes) {
+            Stats::counters().lsystem_cache_misses++;
+            return LSystem_2D::drawLSystem(l_system_2D, color, memoized);
+        }
+    }
+
+    // Lines are kept as a mesh in the plane z = 0, a line that starts where the previous one ended shares its point
+    Lines2D l_system_lines;
+    bool drawn = false;
+    const Figure figure = cached(lines_key, l_system_2D, hash, 2, [&]() {
+        l_system_lines = LSystem_2D::drawLSystem(l_system_2D, color, memoized);
+        drawn = true;
+        Figure x;
+        Points3D &points = x.get_points();
+        for (Line2D &i : l_system_lines) {
+            const int last = static_cast<int>(points.size()) - 1;
+            const bool joint = last != -1 && points.x_data()[last] == i.getP1().getX()
+                               && points.y_data()[last] == i.getP1().getY();
+            if (!joint) points.emplace_back(Vector3D::point(i.getP1().getX(), i.getP1().getY(), 0));
+            points.emplace_back(Vector3D::point(i.getP2().getX(), i.getP2().getY(), 0));
+            x.add_face({static_cast<int>(points.size() - 2), static_cast<int>(points.size() - 1)});
+        }
+        return x;
+    });
+    if (drawn) return l_system_lines;
+
+    const Points3D &points = figure.get_points();
+    for (unsigned int i = 0; i != figure.nr_faces(); i++) {
+        const Face face = figure.get_face(i);
+        l_system_lines.emplace_back(Point2D(points.x_data()[face[0]], points.y_data()[face[0]]),
+                                    Point2D(points.x_data()[face[1]], points.y_data()[face[1]]), color);
+    }
+    return l_system_lines;
+}
+
+Figure LSystemCache::draw_3D(LParser::LSystem3D &l_system_3D, const uint64_t hash) {
+
+    if (l_system_3D.get_stochastic()) return LSystem_3D::drawLSystem(l_system_3D);
+
+    return cached(key("3DLSystem", hash, l_system_3D.get_nr_iterations()), l_system_3D, hash, 3,
+                  [&]() { return LSystem_3D::drawLSystem(l_system_3D); });
+}
+
+void LSystemCache::set_directory(const std::string &x) {
+    directory = x;
+}
+
+void LSystemCache::clear() {
+    systems_2D.clear();
+    systems_3D.clear();
+    requested_2D.clear();
+}
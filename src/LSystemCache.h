@@ -0,0 +1,83 @@
+//
+// Created by Pablo Deputter on 12/05/2021.
+//
+
+#ifndef ENGINE_LSYSTEMCACHE_H
+#define ENGINE_LSYSTEMCACHE_H
+
+#include <cstdint>
+#include <string>
+#include "l_parser.h"
+#include "Figure.h"
+#include "Line2D.h"
+
+/**
+ * @brief Namespace holding a process-wide cache of L-systems, keyed by a hash of the content of their file
+ *
+ * Parsed rule tables are kept in memory, so a file that is used by several renders is only parsed once. The lines of
+ * deterministic L-systems are kept in the MeshCache and, if a directory is set, in a binary file in that directory, so
+ * a later render or a later run of the engine does not expand them again. Stochastic L-systems depend on their seed,
+ * their lines are always drawn. Without a directory, the lines of a 2D L-system are only copied into the MeshCache
+ * when they are asked for a second time and fit the capacity, so a single render does not hold them twice.
+ */
+namespace LSystemCache {
+
+    /**
+     * @brief Get LSystem2D of a file, parsed once for every content
+     *
+     * @param file_name Name of the .L2D file
+     * @param hash Holds the hash of the content afterwards
+     *
+     * @return Copy of the parsed LSystem2D
+     */
+    LParser::LSystem2D load_2D(const std::string &file_name, uint64_t &hash);
+
+    /**
+     * @brief Get LSystem3D of a file, parsed once for every content
+     *
+     * @param file_name Name of the .L3D file
+     * @param hash Holds the hash of the content afterwards
+     *
+     * @return Copy of the parsed LSystem3D
+     */
+    LParser::LSystem3D load_3D(const std::string &file_name, uint64_t &hash);
+
+    /**
+     * @brief Get lines of a LSystem2D, see LSystem_2D::drawLSystem
+     *
+     * @param l_system_2D LSystem2D returned by load_2D
+     * @param hash Hash returned by load_2D
+     * @param color Color of the lines
+     * @param memoize Draw memoizable LSystems with LSystem_2D::drawLSystem_memoized, cached apart from the others
+     *
+     * @return Lines2D of the LSystem2D
+     */
+    Lines2D draw_2D(LParser::LSystem2D &l_system_2D, const uint64_t hash, const cc::Color &color,
+                    const bool memoize = false);
+
+    /**
+     * @brief Get figure of a LSystem3D, see LSystem_3D::drawLSystem
+     *
+     * @param l_system_3D LSystem3D returned by load_3D
+     * @param hash Hash returned by load_3D
+     *
+     * @return Figure of the LSystem3D, sharing the cached mesh
+     */
+    Figure draw_3D(LParser::LSystem3D &l_system_3D, const uint64_t hash);
+
+    /**
+     * @brief Set directory the lines of deterministic L-systems are written to and read from, empty keeps them in
+     * memory only
+     *
+     * @param directory Existing directory
+     */
+    void set_directory(const std::string &directory);
+
+    /**
+     * @brief Drop every parsed L-system kept in memory and forget which lines were asked for, cached lines are dropped
+     * with MeshCache::clear
+     */
+    void clear();
+}
+
+#endif //ENGINE_LSYSTEMCACHE_H
@@ -0,0 +1,287 @@
+//
+// Created by Pablo Deputter on 10/05/2021.
+//
+
+#include "LSystemExpansion.h"
+#include <algorithm>
+#include <limits>
+#include <new>
+#include "Parallel.h"
+#include "Random.h"
+
+namespace {
+
+    /**
+     * @brief Strings shorter than this are expanded on the calling thread
+     */
+    const uint64_t PARALLEL_LENGTH = uint64_t(1) << 16;
+
+    /**
+     * @brief Part of the string, symbol expanded depth more times, written from offset on, key identifies the symbol in
+     * the tree of replacements
+     */
+    struct Task {
+        char symbol;
+        unsigned int depth;
+        uint64_t key;
+        uint64_t offset;
+    };
+
+    /**
+     * @brief Add without overflowing, UINT64_MAX stands for a length that does not fit
+     */
+    uint64_t saturated_add(const uint64_t a, const uint64_t b) {
+        return a > std::numeric_limits<uint64_t>::max() - b ? std::numeric_limits<uint64_t>::max() : a + b;
+    }
+
+    /**
+     * @brief Get length of every symbol after every amount of iterations, see LSystemExpansion::symbol_lengths
+     *
+     * @param shortest Stochastic symbols take their shortest rule instead of their first one, which gives a lower bound
+     * @param base Value of every symbol before it is replaced, 1 counts every symbol
+     */
+    std::vector<uint64_t> lengths_table(const LParser::LSystem &l_system, const unsigned int iterations,
+                                        const bool shortest, const std::vector<uint64_t> &base) {
+
+        std::vector<uint64_t> lengths;
+        lengths.reserve((iterations + std::size_t(1)) * 256);
+        for (unsigned int k = 0; k <= iterations; k++) lengths.insert(lengths.end(), base.begin(), base.end());
+        auto rule_length = [](const uint64_t *previous, const char *rule, const std::size_t length) {
+            uint64_t total = 0;
+            for (std::size_t i = 0; i != length; i++) {
+                total = saturated_add(total, previous[static_cast<unsigned char>(rule[i])]);
+            }
+            return total;
+        };
+        for (unsigned int k = 1; k <= iterations; k++) {
+            const uint64_t *previous = &lengths[(k - 1) * std::size_t(256)];
+            for (const char &i : l_system.get_alphabet()) {
+                const LParser::LSystem::Symbol &entry = l_system.get_symbol(i);
+                if (!entry.rewritten) continue;
+                uint64_t length = rule_length(previous, entry.replacement, entry.replacement_length);
+                if (shortest) {
+                    for (const LParser::LSystem::StochasticRule &j : l_system.get_stochastic_rules(i)) {
+                        length = std::min(length, rule_length(previous, j.replacement->data(), j.replacement->size()));
+                    }
+                }
+                lengths[k * std::size_t(256) + static_cast<unsigned char>(i)] = length;
+            }
+        }
+        return lengths;
+    }
+
+    /**
+     * @brief Get rule that replaces symbol x, identified by key
+     */
+    void get_rule(const LParser::LSystem &l_system, const char x, const uint64_t key, const char *&rule,
+                  std::size_t &length) {
+
+        if (l_system.get_stochastic()) {
+            const std::string &replacement = l_system.get_replacement_stochastic(x, key);
+            rule = replacement.data();
+            length = replacement.size();
+            return;
+        }
+        rule = l_system.get_symbol(x).replacement;
+        length = l_system.get_symbol(x).replacement_length;
+    }
+
+    /**
+     * @brief Write symbol x expanded depth times to out, out points past the written symbols afterwards
+     */
+    void write(const LParser::LSystem &l_system, const char x, const unsigned int depth, const uint64_t key,
+               char *&out) {
+
+        if (depth == 0 || !l_system.get_symbol(x).rewritten) {
+            *out++ = x;
+            return;
+        }
+        const char *rule;
+        std::size_t length;
+        get_rule(l_system, x, key, rule, length);
+        for (std::size_t i = 0; i != length; i++) {
+            write(l_system, rule[i], depth - 1, Random::child(key, i), out);
+        }
+    }
+
+    /**
+     * @brief Count symbols of a stochastic symbol x expanded depth times, stops once more than budget are counted
+     */
+    uint64_t count(const LParser::LSystem &l_system, const char x, const unsigned int depth, const uint64_t key,
+                   const uint64_t budget) {
+
+        if (depth == 0 || !l_system.get_symbol(x).rewritten) return 1;
+        const char *rule;
+        std::size_t length;
+        get_rule(l_system, x, key, rule, length);
+        uint64_t total = 0;
+        for (std::size_t i = 0; i != length && total <= budget; i++) {
+            total += count(l_system, rule[i], depth - 1, Random::child(key, i), budget - total);
+        }
+        return total;
+    }
+}
+
+std::vector<uint64_t> LSystemExpansion::symbol_lengths(const LParser::LSystem &l_system,
+                                                       const unsigned int iterations) {
+    return lengths_table(l_system, iterations, false, std::vector<uint64_t>(256, 1));
+}
+
+uint64_t LSystemExpansion::expanded_length(const LParser::LSystem &l_system, const std::string &initiator,
+                                           const unsigned int iterations) {
+
+    const std::vector<uint64_t> lengths = symbol_lengths(l_system, iterations);
+    uint64_t length = 0;
+    for (const char &i : initiator) {
+        length = saturated_add(length, lengths[iterations * std::size_t(256) + static_cast<unsigned char>(i)]);
+    }
+    return length;
+}
+
+uint64_t LSystemExpansion::expanded_count(const LParser::LSystem &l_system, const std::string &initiator,
+                                          const unsigned int iterations, const LParser::LSystem::SymbolType type) {
+
+    std::vector<uint64_t> base(256, 0);
+    for (std::size_t i = 0; i != 256; i++) base[i] = l_system.get_symbol(static_cast<char>(i)).type == type;
+    const std::vector<uint64_t> counts = lengths_table(l_system, iterations, false, base);
+    uint64_t count = 0;
+    for (const char &i : initiator) {
+        count = saturated_add(count, counts[iterations * std::size_t(256) + static_cast<unsigned char>(i)]);
+    }
+    return count;
+}
+
+uint64_t LSystemExpansion::max_bracket_depth(const LParser::LSystem &l_system, const std::string &initiator,
+                                             const unsigned int iterations) {
+
+    // Per symbol after k iterations: the change in open brackets and the deepest nesting reached, kept within
+    // +-MAX_LENGTH so unbalanced rules cannot overflow
+    const int64_t bound = static_cast<int64_t>(MAX_LENGTH);
+    auto clamp = [bound](const int64_t x) { return std::max(-bound, std::min(bound, x)); };
+    std::vector<int64_t> net(256, 0);
+    std::vector<int64_t> deepest(256, 0);
+    for (std::size_t i = 0; i != 256; i++) {
+        const LParser::LSystem::SymbolType type = l_system.get_symbol(static_cast<char>(i)).type;
+        if (type == LParser::LSystem::PUSH) net[i] = deepest[i] = 1;
+        else if (type == LParser::LSystem::POP) net[i] = -1;
+    }
+    auto walk = [&](const char *rule, const std::size_t length, int64_t &change, int64_t &depth) {
+        change = 0;
+        depth = 0;
+        for (std::size_t i = 0; i != length; i++) {
+            const unsigned char x = static_cast<unsigned char>(rule[i]);
+            depth = std::max(depth, clamp(change + deepest[x]));
+            change = clamp(change + net[x]);
+        }
+    };
+    for (unsigned int k = 1; k <= iterations; k++) {
+        std::vector<int64_t> next_net(net);
+        std::vector<int64_t> next_deepest(deepest);
+        for (const char &i : l_system.get_alphabet()) {
+            const LParser::LSystem::Symbol &entry = l_system.get_symbol(i);
+            if (!entry.rewritten) continue;
+            const unsigned char x = static_cast<unsigned char>(i);
+            walk(entry.replacement, entry.replacement_length, next_net[x], next_deepest[x]);
+        }
+        net.swap(next_net);
+        deepest.swap(next_deepest);
+    }
+    int64_t change;
+    int64_t depth;
+    walk(initiator.data(), initiator.size(), change, depth);
+    return static_cast<uint64_t>(depth);
+}
+
+std::string LSystemExpansion::expand(const LParser::LSystem &l_system, const std::string &initiator,
+                                     const unsigned int iterations, const uint64_t max_length) {
+
+    const uint64_t limit = std::min<uint64_t>(max_length, std::string().max_size());
+    const bool stochastic = l_system.get_stochastic();
+
+    // Replace the top of the tree until there are enough parts to even out the work of every thread
+    std::vector<Task> tasks;
+    const uint64_t root = Random::mix(l_system.get_seed());
+    for (std::size_t i = 0; i != initiator.size(); i++) {
+        tasks.push_back(Task{initiator[i], iterations, Random::child(root, i), 0});
+    }
+    const std::size_t nr_tasks = 64 * std::size_t(Parallel::nr_threads());
+    while (tasks.size() < nr_tasks) {
+        std::vector<Task> next;
+        bool replaced = false;
+        for (const Task &i : tasks) {
+            if (i.depth == 0 || !l_system.get_symbol(i.symbol).rewritten) {
+                next.push_back(i);
+                continue;
+            }
+            const char *rule;
+            std::size_t length;
+            get_rule(l_system, i.symbol, i.key, rule, length);
+            for (std::size_t j = 0; j != length; j++) {
+                next.push_back(Task{rule[j], i.depth - 1, Random::child(i.key, j), 0});
+            }
+            replaced = true;
+        }
+        if (!replaced) break;
+        tasks.swap(next);
+    }
+
+    // Lengths of deterministic parts come from the table, stochastic parts are counted with the same random values
+    // that fill them afterwards
+    std::vector<uint64_t> task_lengths(tasks.size());
+    if (!stochastic) {
+        const std::vector<uint64_t> lengths = symbol_lengths(l_system, iterations);
+        for (std::size_t i = 0; i != tasks.size(); i++) {
+            task_lengths[i] = lengths[tasks[i].depth * std::size_t(256) + static_cast<unsigned char>(tasks[i].symbol)];
+        }
+    }
+    else {
+        // Strings that cannot fit even with the shortest rules fail before anything is counted
+        const std::vector<uint64_t> shortest = lengths_table(l_system, iterations, true,
+                                                             std::vector<uint64_t>(256, 1));
+        uint64_t lower_bound = 0;
+        for (const char &i : initiator) {
+            lower_bound = saturated_add(lower_bound,
+                                        shortest[iterations * std::size_t(256) + static_cast<unsigned char>(i)]);
+        }
+        if (lower_bound > limit) throw std::bad_alloc();
+
+        // Every thread stops counting once its own parts are longer than the limit
+        Parallel::for_range("count symbols", tasks.size(), 1, [&](std::size_t begin, std::size_t end) {
+            uint64_t counted = 0;
+            for (std::size_t i = begin; i != end; i++) {
+                task_lengths[i] = counted > limit ? 0
+                                  : count(l_system, tasks[i].symbol, tasks[i].depth, tasks[i].key, limit - counted);
+                counted += task_lengths[i];
+            }
+            if (counted > limit) task_lengths[begin] = std::numeric_limits<uint64_t>::max();
+        });
+    }
+
+    // Exclusive prefix sum gives every part its offset, the total length is checked before allocating
+    uint64_t total = 0;
+    for (std::size_t i = 0; i != tasks.size(); i++) {
+        tasks[i].offset = total;
+        total = saturated_add(total, task_lengths[i]);
+    }
+    if (total > limit) throw std::bad_alloc();
+
+    std::string x(static_cast<std::size_t>(total), '\0');
+    char *data = &x[0];
+
+    // Thread t writes the parts that start in [total * t / threads, total * (t + 1) / threads)
+    const std::size_t nr_threads = total < PARALLEL_LENGTH ? 1 : Parallel::nr_threads();
+    auto first_task = [&](const std::size_t thread) {
+        const uint64_t offset = total / nr_threads * thread + total % nr_threads * thread / nr_threads;
+        return std::lower_bound(tasks.begin(), tasks.end(), offset, [](const Task &a, const uint64_t b) {
+            return a.offset < b;
+        }) - tasks.begin();
+    };
+    Parallel::for_range("expand symbols", nr_threads, 1, [&](std::size_t begin, std::size_t end) {
+        const std::size_t last = end == nr_threads ? tasks.size() : first_task(end);
+        for (std::size_t i = first_task(begin); i < last; i++) {
+            char *out = data + tasks[i].offset;
+            write(l_system, tasks[i].symbol, tasks[i].depth, tasks[i].key, out);
+        }
+    });
+    return x;
+}
@@ -0,0 +1,93 @@
+//
+// Created by Pablo Deputter on 10/05/2021.
+//
+
+#ifndef ENGINE_LSYSTEMEXPANSION_H
+#define ENGINE_LSYSTEMEXPANSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "l_parser.h"
+
+/**
+ * @brief Namespace holding the expansion of a LSystem into its full string
+ *
+ * The length of every symbol after every amount of iterations is known up front, so each part of the string gets its
+ * offset from a prefix sum and the parts are filled by different threads. The result is the same as expanding the
+ * string one iteration at a time. Stochastic symbols draw their replacement from a random value keyed by their place
+ * in the tree of replacements, so their parts are counted first and filled with the same choices afterwards.
+ */
+namespace LSystemExpansion {
+
+    /**
+     * @brief Longest string expand() builds unless asked otherwise, 4 GiB
+     */
+    const uint64_t MAX_LENGTH = uint64_t(1) << 32;
+
+    /**
+     * @brief Get length of every symbol after every amount of iterations
+     *
+     * @param l_system LSystem holding the replacement rules
+     * @param iterations Amount of times every symbol is replaced
+     *
+     * @return lengths[k * 256 + c] is the length of symbol c after k iterations, UINT64_MAX if it does not fit
+     */
+    std::vector<uint64_t> symbol_lengths(const LParser::LSystem &l_system, const unsigned int iterations);
+
+    /**
+     * @brief Get length of the string after a given amount of iterations, without expanding it
+     *
+     * @param l_system LSystem holding the replacement rules, stochastic symbols are counted with their first rule
+     * @param initiator String to start from
+     * @param iterations Amount of times every symbol is replaced
+     *
+     * @return Length as uint64_t, UINT64_MAX if it does not fit
+     */
+    uint64_t expanded_length(const LParser::LSystem &l_system, const std::string &initiator,
+                             const unsigned int iterations);
+
+    /**
+     * @brief Get amount of symbols of a given type in the string after a given amount of iterations, without expanding
+     * it, e.g. the amount of lines for LParser::LSystem::DRAW
+     *
+     * @param l_system LSystem holding the replacement rules, stochastic symbols are counted with their first rule
+     * @param initiator String to start from
+     * @param iterations Amount of times every symbol is replaced
+     * @param type Type of the symbols that are counted
+     *
+     * @return Amount as uint64_t, UINT64_MAX if it does not fit
+     */
+    uint64_t expanded_count(const LParser::LSystem &l_system, const std::string &initiator,
+                            const unsigned int iterations, const LParser::LSystem::SymbolType type);
+
+    /**
+     * @brief Get deepest nesting of brackets in the string after a given amount of iterations, without expanding it
+     *
+     * @param l_system LSystem holding the replacement rules, stochastic symbols are counted with their first rule
+     * @param initiator String to start from
+     * @param iterations Amount of times every symbol is replaced
+     *
+     * @return Amount of brackets that are open at the same time, at most MAX_LENGTH
+     */
+    uint64_t max_bracket_depth(const LParser::LSystem &l_system, const std::string &initiator,
+                               const unsigned int iterations);
+
+    /**
+     * @brief Expand initiator a given amount of iterations over every thread of Parallel, gives the same string as
+     * walking a LSystemIterator
+     *
+     * @param l_system LSystem holding the replacement rules
+     * @param initiator String to start from
+     * @param iterations Amount of times every symbol is replaced
+     * @param max_length Longest string that may be built, checked before anything is allocated
+     *
+     * @throws std::bad_alloc if the string would be longer than max_length
+     *
+     * @return Expanded string
+     */
+    std::string expand(const LParser::LSystem &l_system, const std::string &initiator, const unsigned int iterations,
+                       const uint64_t max_length = MAX_LENGTH);
+}
+
+#endif //ENGINE_LSYSTEMEXPANSION_H
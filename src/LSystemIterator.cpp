@@ -0,0 +1,47 @@
+//
+// Created by Pablo Deputter on 10/05/2021.
+//
+
+#include "LSystemIterator.h"
+#include "Random.h"
+
+LSystemIterator::LSystemIterator(const LParser::LSystem &l_system, const unsigned int iterations)
+        : LSystemIterator(l_system, l_system.get_initiator(), iterations) {}
+
+LSystemIterator::LSystemIterator(const LParser::LSystem &l_system, const std::string &initiator,
+                                 const unsigned int iterations) : l_system(l_system) {
+
+    // A frame is pushed per iteration at most, so frames never reallocate
+    frames.reserve(iterations + 1);
+    frames.push_back(Frame{initiator.data(), initiator.size(), 0, iterations, Random::mix(l_system.get_seed())});
+}
+
+bool LSystemIterator::next(char &symbol) {
+
+    while (!frames.empty()) {
+        Frame &frame = frames.back();
+        if (frame.position == frame.length) {
+            frames.pop_back();
+            continue;
+        }
+
+        const char x = frame.rule[frame.position++];
+        const LParser::LSystem::Symbol &entry = l_system.get_symbol(x);
+        if (frame.depth == 0 || !entry.rewritten) {
+            symbol = x;
+            return true;
+        }
+
+        // Descend into the replacement of x, frame is invalidated by the push
+        const unsigned int depth = frame.depth - 1;
+        if (l_system.get_stochastic()) {
+            const uint64_t key = Random::child(frame.key, frame.position - 1);
+            const std::string &rule = l_system.get_replacement_stochastic(x, key);
+            frames.push_back(Frame{rule.data(), rule.size(), 0, depth, key});
+        }
+        else {
+            frames.push_back(Frame{entry.replacement, entry.replacement_length, 0, depth, 0});
+        }
+    }
+    return false;
+}
@@ -0,0 +1,72 @@
+//
+// Created by Pablo Deputter on 10/05/2021.
+//
+
+#ifndef ENGINE_LSYSTEMITERATOR_H
+#define ENGINE_LSYSTEMITERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "l_parser.h"
+
+/**
+ * @brief Walks the symbols of a LSystem after a given amount of iterations depth-first, the expanded string is never
+ * built so memory only depends on the amount of iterations and the length of the replacement rules
+ *
+ * A stochastic symbol picks its replacement with a random value keyed by its position in the tree of replacements and
+ * the seed of the LSystem, so the result is the same as the one of LSystemExpansion::expand.
+ */
+class LSystemIterator {
+
+private:
+    /**
+     * @brief Rule that is being walked, depth is the amount of iterations left for its symbols and key identifies the
+     * symbol it replaces, see Random::child
+     */
+    struct Frame {
+        const char *rule;
+        std::size_t length;
+        std::size_t position;
+        unsigned int depth;
+        uint64_t key;
+    };
+
+    /**
+     * @brief l_system LSystem holding the replacement rules
+     */
+    const LParser::LSystem &l_system;
+    /**
+     * @brief frames Rules from the initiator down to the rule of the current symbol
+     */
+    std::vector<Frame> frames;
+
+public:
+    /**
+     * @brief Constructor for LSystemIterator object
+     *
+     * @param l_system LSystem to be walked, has to outlive the iterator
+     * @param iterations Amount of times every symbol is replaced
+     */
+    LSystemIterator(const LParser::LSystem &l_system, const unsigned int iterations);
+
+    /**
+     * @brief Constructor for LSystemIterator object that starts from another string than the initiator
+     *
+     * @param l_system LSystem to be walked, has to outlive the iterator
+     * @param initiator String to start from, has to outlive the iterator
+     * @param iterations Amount of times every symbol is replaced
+     */
+    LSystemIterator(const LParser::LSystem &l_system, const std::string &initiator, const unsigned int iterations);
+
+    /**
+     * @brief Get next symbol of the expanded string
+     *
+     * @param symbol Holds the symbol afterwards
+     *
+     * @return false if every symbol was walked
+     */
+    bool next(char &symbol);
+};
+
+#endif //ENGINE_LSYSTEMITERATOR_H
@@ -78,23 +78,19 @@ double PointLight::getAngle() const {
 }
 
 
-void PointLight::createShadowMask(Figures3D &triangulated_figures, const int size) {
-
-    Lines2D shadow_lines;
-
-    // Do projection and generate lines
-    Utils::generate_lines(triangulated_figures, shadow_lines, this->eye);
-
-    // Calculate x-min, y-min, x-max, and y-max
-    std::tuple<std::pair<double, double>, std::pair<double, double>> max_line2D = Line2D::Line2D_findMax(shadow_lines);
-    double x = std::get<0>(max_line2D).first;
-    double y = std::get<0>(max_line2D).second;
-
-    double X = std::get<1>(max_line2D).first;
-    double Y = std::get<1>(max_line2D).second;
+void PointLight::createShadowMask(const Figures3D &triangulated_figures, const int size) {
+
+    // Points in "light-coordinate-system", model and light transformation are applied in one pass that also
+    // calculates x-min, y-min, x-max, and y-max of the projection
+    Transform::Bounds bounds;
+    Points3D points;
+    for (const Figure &i : triangulated_figures) {
+        i.project_bounds(this->eye, points, bounds);
+    }
 
     // Calculate image_x, image_y, d, dx, dy
-    std::tuple<double, double, double, double, double> data = Utils::calculate_data(x, X, y, Y, size);
+    std::tuple<double, double, double, double, double> data = Utils::calculate_data(bounds.x_min, bounds.x_max,
+                                                                                    bounds.y_min, bounds.y_max, size);
     double image_x = std::get<0>(data);
     double image_y = std::get<1>(data);
     this->d = std::get<2>(data);
@@ -103,14 +99,16 @@ void PointLight::createShadowMask(Figures3D &triangulated_figures, const int siz
 
     this->shadowMask = ZBuffer( (unsigned int) std::round(image_x), (unsigned int) std::round(image_y));
 
-    // Create shadowMask
-    for (Figure &i : triangulated_figures) {
-        for (Face &j : i.get_faces()) {
+    // Create shadowMask, every instance is transformed again instead of keeping all of them in memory
+    for (const Figure &i : triangulated_figures) {
+        Utils::for_each_instance(i, this->eye, [&](const Matrix &transformation) {
+            points = i.get_points();
+            points.transform(transformation);
+            for (const Triangle &j : i.get_triangles()) {
 
-            PointLight::fillShadowMask(i.get_points()[j.get_point_indexes()[0]],
-                                       i.get_points()[j.get_point_indexes()[1]],
-                                       i.get_points()[j.get_point_indexes()[2]], size);
-        }
+                PointLight::fillShadowMask(points[j.a], points[j.b], points[j.c], size);
+            }
+        });
     }
 }
 
@@ -91,10 +91,10 @@ public:
     /**
      * @brief Create shadowMask for Light
      *
-     * @param figures List containing figures which z-values will be added in ZBuffer
+     * @param figures List containing triangulated figures in model-coordinates which z-values will be added in ZBuffer
      * @param size Height and Width of ZBuffer
      */
-    virtual void createShadowMask(Figures3D &figures, const int size) {
+    virtual void createShadowMask(const Figures3D &figures, const int size) {
         std::ignore = figures;
         std::ignore = size;
     }
@@ -368,7 +368,7 @@ public:
      * @param figures List containing figures which z-values will be added in ZBuffer
      * @param size Height and Width of ZBuffer
      */
-    void createShadowMask(Figures3D &triangulated_figures, const int size) override;
+    void createShadowMask(const Figures3D &triangulated_figures, const int size) override;
 
     /**
      * @brief Fill shadowMask with given triangle
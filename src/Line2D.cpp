@@ -62,16 +62,7 @@ std::tuple<std::pair<double, double>, std::pair<double, double>> Line2D::Line2D_
     return std::make_tuple(std::make_pair(x, y), std::make_pair(X, Y));
 }
 
-void Line2D::draw2DLines(Lines2D &line2D, const int &size, img::EasyImage &image, bool ZBuffering) {
-
-    // Calculate x-min, y-min, x-max and y-max
-    std::tuple<std::pair<double, double>, std::pair<double, double>> max_line2D = Line2D::Line2D_findMax(line2D);
-
-    double x = std::get<0>(max_line2D).first;
-    double y = std::get<0>(max_line2D).second;
-
-    double X = std::get<1>(max_line2D).first;
-    double Y = std::get<1>(max_line2D).second;
+Line2D::Fit Line2D::fit(const double &x, const double &y, const double &X, const double &Y, const int &size) {
 
     // Calculate x-range, y-range
     double xrange = X - x;
@@ -80,27 +71,39 @@ void Line2D::draw2DLines(Lines2D &line2D, const int &size, img::EasyImage &image
     // Calculate max(xrange, yrange)
     double range = xrange > yrange ? xrange : yrange;
 
+    Fit fit;
+
     // Calculate dimensions of image
-    double image_x = size*(xrange/range);
-    double image_y = size*(yrange/range);
+    fit.image_x = size*(xrange/range);
+    fit.image_y = size*(yrange/range);
 
     // Calculate scale-factor
-    double d = 0.95*(image_x/xrange);
+    fit.d = 0.95*(fit.image_x/xrange);
+
+    double DC_x = fit.d*((x + X)/2);
+    double DC_y = fit.d*((y + Y)/2);
+
+    fit.dx = (fit.image_x/2) - DC_x;
+    fit.dy = (fit.image_y/2) - DC_y;
+    return fit;
+}
+
+void Line2D::draw2DLines(Lines2D &line2D, const int &size, img::EasyImage &image, bool ZBuffering) {
+
+    // Calculate x-min, y-min, x-max and y-max
+    std::tuple<std::pair<double, double>, std::pair<double, double>> max_line2D = Line2D::Line2D_findMax(line2D);
+
+    const Fit fit = Line2D::fit(std::get<0>(max_line2D).first, std::get<0>(max_line2D).second,
+                                std::get<1>(max_line2D).first, std::get<1>(max_line2D).second, size);
 
     // Multiply coordinates of all points with scale-factor
     for (Line2D & i : line2D) {
-        i.line2D_scale(d);
+        i.line2D_scale(fit.d);
     }
 
-    double DC_x = d*((x + X)/2);
-    double DC_y = d*((y + Y)/2);
-
-    double dx = (image_x/2) - DC_x;
-    double dy = (image_y/2) - DC_y;
-
     // Move all coordinates
     for (Line2D & i : line2D) {
-        i.line2D_move(dx, dy);
+        i.line2D_move(fit.dx, fit.dy);
     }
 
     // Round all points
@@ -109,7 +112,7 @@ void Line2D::draw2DLines(Lines2D &line2D, const int &size, img::EasyImage &image
     }
 
     // Change image dimensions
-    image.image_resize(static_cast<int>(std::round(image_x)), static_cast<int>(std::round(image_y)));
+    image.image_resize(static_cast<int>(std::round(fit.image_x)), static_cast<int>(std::round(fit.image_y)));
 
     // Draw lines
     if (!ZBuffering) {
@@ -123,7 +126,7 @@ void Line2D::draw2DLines(Lines2D &line2D, const int &size, img::EasyImage &image
         }
     }
     else {
-        ZBuffer buffer = ZBuffer((unsigned int)(std::round(image_x)), (unsigned int)(std::round(image_y)));
+        ZBuffer buffer = ZBuffer((unsigned int)(std::round(fit.image_x)), (unsigned int)(std::round(fit.image_y)));
 
         for (Line2D & i : line2D) {
 
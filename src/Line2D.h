@@ -135,6 +135,30 @@ public:
     */
     static std::tuple<std::pair<double, double>, std::pair<double, double>> Line2D_findMax(Lines2D &line2D);
 
+    /**
+    * \brief Scale-factor, offset and image dimensions that fit lines within given bounds on an image
+    */
+    struct Fit {
+        double d;
+        double dx;
+        double dy;
+        double image_x;
+        double image_y;
+    };
+
+    /**
+    * \brief Fit lines within given bounds on an image, point p is drawn on round(p * d + (dx, dy))
+    *
+    * \param x x-min of the lines
+    * \param y y-min of the lines
+    * \param X x-max of the lines
+    * \param Y y-max of the lines
+    * \param size Maximum amount of pixels of image
+    *
+    * \return Fit of the lines
+    */
+    static Fit fit(const double &x, const double &y, const double &X, const double &Y, const int &size);
+
     /**
     * \brief Draws list of Line2D objects representing straight lines on image
     *
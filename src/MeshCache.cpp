@@ -0,0 +1,86 @@
+//
+// Created by Pablo Deputter on 09/05/2021.
+//
+
+#include "MeshCache.h"
+#include <limits>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+#include "Stats.h"
+
+namespace {
+
+    struct Entry {
+        std::string key;
+        Figure figure;
+        std::size_t bytes;
+    };
+
+    /**
+     * @brief Cached meshes, most recently used first
+     */
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    std::size_t capacity = std::size_t(256) << 20;
+    std::size_t bytes = 0;
+
+    /**
+     * @brief Drop least recently used meshes until the cache fits its capacity
+     */
+    void shrink() {
+        while (bytes > capacity && !entries.empty()) {
+            bytes -= entries.back().bytes;
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+    }
+}
+
+Figure MeshCache::get(const std::string &key, const std::function<Figure()> &generate) {
+
+    std::unordered_map<std::string, std::list<Entry>::iterator>::iterator i = index.find(key);
+    if (i != index.end()) {
+        entries.splice(entries.begin(), entries, i->second);
+        Stats::counters().mesh_cache_hits++;
+        return entries.front().figure;
+    }
+
+    Figure figure = generate();
+    Stats::counters().mesh_cache_misses++;
+    if (capacity == 0) return figure;
+
+    entries.push_front(Entry{key, figure, figure.get_mesh().bytes()});
+    index[key] = entries.begin();
+    bytes += entries.front().bytes;
+    shrink();
+    return figure;
+}
+
+std::string MeshCache::key(const std::string &type, const std::vector<double> &parameters) {
+
+    std::ostringstream x;
+    x.precision(std::numeric_limits<double>::max_digits10);
+    x << type;
+    for (double i : parameters) x << ' ' << i;
+    return x.str();
+}
+
+void MeshCache::set_capacity(const std::size_t x) {
+    capacity = x;
+    shrink();
+}
+
+std::size_t MeshCache::get_capacity() {
+    return capacity;
+}
+
+std::size_t MeshCache::size() {
+    return bytes;
+}
+
+void MeshCache::clear() {
+    entries.clear();
+    index.clear();
+    bytes = 0;
+}
@@ -0,0 +1,70 @@
+//
+// Created by Pablo Deputter on 09/05/2021.
+//
+
+#ifndef ENGINE_MESHCACHE_H
+#define ENGINE_MESHCACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Figure.h"
+
+/**
+ * @brief Namespace holding a process-wide cache of generated primitive meshes
+ *
+ * Figures handed out by the cache share their Mesh, a figure that changes its points or faces gets its own copy. The
+ * cache lives as long as the process, so every render of a batch reuses the meshes of the renders before it. Least
+ * recently used meshes are dropped once the cache holds more than its capacity.
+ */
+namespace MeshCache {
+
+    /**
+     * @brief Get figure holding the mesh of key, generate is only called if the mesh is not cached
+     *
+     * @param key Type of the primitive and every parameter of its generator
+     * @param generate Generates the figure
+     *
+     * @return Figure sharing the cached mesh
+     */
+    Figure get(const std::string &key, const std::function<Figure()> &generate);
+
+    /**
+     * @brief Build key of a primitive, every parameter is written with full precision
+     *
+     * @param type Type of the primitive
+     * @param parameters Parameters of its generator
+     *
+     * @return Key as std::string
+     */
+    std::string key(const std::string &type, const std::vector<double> &parameters);
+
+    /**
+     * @brief Set maximal amount of bytes held by the cache, 0 disables the cache
+     *
+     * @param bytes Capacity in bytes
+     */
+    void set_capacity(const std::size_t bytes);
+
+    /**
+     * @brief Get maximal amount of bytes held by the cache
+     *
+     * @return Capacity in bytes, 0 if the cache is disabled
+     */
+    std::size_t get_capacity();
+
+    /**
+     * @brief Get amount of bytes held by the cache
+     *
+     * @return Amount as std::size_t
+     */
+    std::size_t size();
+
+    /**
+     * @brief Drop every cached mesh
+     */
+    void clear();
+}
+
+#endif //ENGINE_MESHCACHE_H
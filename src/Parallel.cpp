@@ -0,0 +1,80 @@
+//
+// Created by Pablo Deputter on 09/05/2021.
+//
+
+#include "Parallel.h"
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Trace.h"
+
+namespace {
+
+    /**
+     * @brief Amount of threads set by the user, 0 if every core is used
+     */
+    unsigned int threads = 0;
+
+    /**
+     * @brief Call function on [begin, end) as a span on the trace lane of the worker
+     *
+     * @param worker Index of the range, 0 is the calling thread which keeps its own lane
+     * @param error Set to the exception thrown by function, if any
+     */
+    void run_range(const char *name, const std::size_t worker,
+                   const std::function<void(std::size_t, std::size_t)> &function, const std::size_t begin,
+                   const std::size_t end, std::exception_ptr &error) {
+
+        try {
+            if (worker != 0) Trace::set_thread_name("worker " + std::to_string(worker));
+            Trace::Span span(name);
+            function(begin, end);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+    }
+}
+
+unsigned int Parallel::nr_threads() {
+
+    if (threads != 0) return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void Parallel::set_nr_threads(const unsigned int x) {
+    threads = x;
+}
+
+void Parallel::for_range(const char *name, const std::size_t n, const std::size_t grain,
+                         const std::function<void(std::size_t, std::size_t)> &function) {
+
+    const std::size_t nr_ranges = std::min<std::size_t>(nr_threads(), n / std::max<std::size_t>(1, grain));
+    if (nr_ranges <= 1) {
+        Trace::Span span(name);
+        function(0, n);
+        return;
+    }
+
+    // The calling thread handles the first range itself. Exceptions are kept until every worker is joined, a
+    // std::bad_alloc of one range then reaches the caller like it does single threaded.
+    std::vector<std::exception_ptr> errors(nr_ranges);
+    std::vector<std::thread> workers;
+    workers.reserve(nr_ranges - 1);
+    for (std::size_t i = 1; i != nr_ranges; i++) {
+        try {
+            workers.emplace_back(run_range, name, i, std::cref(function), n * i / nr_ranges, n * (i + 1) / nr_ranges,
+                                 std::ref(errors[i]));
+        }
+        catch (...) {
+            errors[i] = std::current_exception();
+        }
+    }
+    run_range(name, 0, function, 0, n / nr_ranges, errors[0]);
+    for (std::thread &i : workers) i.join();
+    for (const std::exception_ptr &i : errors) {
+        if (i) std::rethrow_exception(i);
+    }
+}
@@ -0,0 +1,49 @@
+//
+// Created by Pablo Deputter on 09/05/2021.
+//
+
+#ifndef ENGINE_PARALLEL_H
+#define ENGINE_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Namespace holding helpers that split work over the cores of the machine
+ *
+ * Work is split in contiguous ranges, one per thread, so a caller that writes the results of index i to slot i of a
+ * preallocated array gets the same output as a single threaded loop.
+ */
+namespace Parallel {
+
+    /**
+     * @brief Get amount of threads work is split over
+     *
+     * @return Amount as unsigned int, at least 1
+     */
+    unsigned int nr_threads();
+
+    /**
+     * @brief Set amount of threads work is split over, 0 uses every core of the machine
+     *
+     * @param x Amount of threads
+     */
+    void set_nr_threads(const unsigned int x);
+
+    /**
+     * @brief Call function on contiguous ranges [begin, end) that together cover [0, n), every range is handled by a
+     * different thread
+     *
+     * Every range is recorded as a span in the trace, the range of worker i on the lane named "worker i". If function
+     * throws, every range still finishes and the exception of the first range that threw is rethrown.
+     *
+     * @param name Name of the work, used for the spans
+     * @param n Amount of items
+     * @param grain Minimal amount of items per thread, smaller amounts of work stay on the calling thread
+     * @param function Called with begin and end of a range
+     */
+    void for_range(const char *name, const std::size_t n, const std::size_t grain,
+                   const std::function<void(std::size_t, std::size_t)> &function);
+}
+
+#endif //ENGINE_PARALLEL_H
@@ -2,8 +2,63 @@
 // Created by Pablo Deputter on 12/03/2021.
 //
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
 #include "Platonic.h"
 
+namespace {
+
+    /**
+     * @brief Open addressing hash table from an edge to the index of its midpoint
+     */
+    class MidpointCache {
+    private:
+        std::vector<uint64_t> keys;
+        std::vector<int> values;
+        unsigned int shift;
+    public:
+        /**
+         * @brief Constructor for MidpointCache object
+         *
+         * @param edges Amount of edges that will be added
+         */
+        explicit MidpointCache(const std::size_t edges) : shift(64) {
+            std::size_t size = 1;
+            while (size < 2 * edges) {
+                size *= 2;
+                shift--;
+            }
+            keys.assign(size, UINT64_MAX);
+            values.resize(size);
+        }
+
+        /**
+         * @brief Get slot of edge ab, empty slot if edge was not added yet
+         */
+        std::size_t find(const int a, const int b) const {
+            const uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | static_cast<uint32_t>(std::max(a, b));
+            std::size_t i = shift == 64 ? 0 : static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+            while (keys[i] != key && keys[i] != UINT64_MAX) i = (i + 1) & (keys.size() - 1);
+            return i;
+        }
+
+        bool empty(const std::size_t slot) const {
+            return keys[slot] == UINT64_MAX;
+        }
+
+        int get(const std::size_t slot) const {
+            return values[slot];
+        }
+
+        void set(const std::size_t slot, const int a, const int b, const int x) {
+            keys[slot] = (static_cast<uint64_t>(std::min(a, b)) << 32) | static_cast<uint32_t>(std::max(a, b));
+            values[slot] = x;
+        }
+    };
+}
+
 Figure Platonic::cube() {
 
     // Origin is located in center of cube
@@ -20,12 +75,12 @@ Figure Platonic::cube() {
     cube.get_points().emplace_back(Vector3D::point(1, -1, 1));
 
     // Add faces 0 -> 1
-    cube.get_faces().emplace_back(Face({7,4,3,8}));
-    cube.get_faces().emplace_back(Face({4,1,2,3}));
-    cube.get_faces().emplace_back(Face({1,6,5,2}));
-    cube.get_faces().emplace_back(Face({6,7,8,5}));
-    cube.get_faces().emplace_back(Face({8,3,2,5}));
-    cube.get_faces().emplace_back(Face({7,6,1,4}));
+    cube.add_face({7,4,3,8});
+    cube.add_face({4,1,2,3});
+    cube.add_face({1,6,5,2});
+    cube.add_face({6,7,8,5});
+    cube.add_face({8,3,2,5});
+    cube.add_face({7,6,1,4});
 
     cube.correct_indexes();
     return cube;
@@ -40,10 +95,10 @@ Figure Platonic::tetrahedron() {
     tetrahedron.add_point_double(std::make_tuple(1,1,1));
     tetrahedron.add_point_double(std::make_tuple(-1,-1,1));
 
-    tetrahedron.get_faces().emplace_back(Face({1,2,3}));
-    tetrahedron.get_faces().emplace_back(Face({2,4,3}));
-    tetrahedron.get_faces().emplace_back(Face({1,4,2}));
-    tetrahedron.get_faces().emplace_back(Face({1,3,4}));
+    tetrahedron.add_triangle(1, 2, 3);
+    tetrahedron.add_triangle(2, 4, 3);
+    tetrahedron.add_triangle(1, 4, 2);
+    tetrahedron.add_triangle(1, 3, 4);
 
     tetrahedron.correct_indexes();
     return tetrahedron;
@@ -60,14 +115,14 @@ Figure Platonic::octahedron() {
     octahedron.add_point_double(std::make_tuple(0,0,-1));
     octahedron.add_point_double(std::make_tuple(0,0,1));
 
-    octahedron.get_faces().emplace_back(Face({1,2,6}));
-    octahedron.get_faces().emplace_back(Face({2,3,6}));
-    octahedron.get_faces().emplace_back(Face({3,4,6}));
-    octahedron.get_faces().emplace_back(Face({4,1,6}));
-    octahedron.get_faces().emplace_back(Face({2,1,5}));
-    octahedron.get_faces().emplace_back(Face({3,2,5}));
-    octahedron.get_faces().emplace_back(Face({4,3,5}));
-    octahedron.get_faces().emplace_back(Face({1,4,5}));
+    octahedron.add_triangle(1, 2, 6);
+    octahedron.add_triangle(2, 3, 6);
+    octahedron.add_triangle(3, 4, 6);
+    octahedron.add_triangle(4, 1, 6);
+    octahedron.add_triangle(2, 1, 5);
+    octahedron.add_triangle(3, 2, 5);
+    octahedron.add_triangle(4, 3, 5);
+    octahedron.add_triangle(1, 4, 5);
 
     octahedron.correct_indexes();
     return octahedron;
@@ -93,26 +148,26 @@ Figure Platonic::icosahedron() {
 
     icosahedron.get_points().emplace_back(Vector3D::point(0, 0, -sqrt(5) / 2));
 
-    icosahedron.get_faces().emplace_back(Face({1, 2, 3}));
-    icosahedron.get_faces().emplace_back(Face({1, 3, 4}));
-    icosahedron.get_faces().emplace_back(Face({1, 4, 5}));
-    icosahedron.get_faces().emplace_back(Face({1, 5, 6}));
-    icosahedron.get_faces().emplace_back(Face({1, 6, 2}));
-    icosahedron.get_faces().emplace_back(Face({2, 7, 3}));
-    icosahedron.get_faces().emplace_back(Face({3, 7, 8}));
-    icosahedron.get_faces().emplace_back(Face({3, 8, 4}));
-    icosahedron.get_faces().emplace_back(Face({4, 8, 9}));
-    icosahedron.get_faces().emplace_back(Face({4, 9, 5}));
-    icosahedron.get_faces().emplace_back(Face({5, 9, 10}));
-    icosahedron.get_faces().emplace_back(Face({5, 10, 6}));
-    icosahedron.get_faces().emplace_back(Face({6, 10, 11}));
-    icosahedron.get_faces().emplace_back(Face({6, 11, 2}));
-    icosahedron.get_faces().emplace_back(Face({2, 11, 7}));
-    icosahedron.get_faces().emplace_back(Face({12, 8, 7}));
-    icosahedron.get_faces().emplace_back(Face({12, 9, 8}));
-    icosahedron.get_faces().emplace_back(Face({12, 10, 9}));
-    icosahedron.get_faces().emplace_back(Face({12, 11, 10}));
-    icosahedron.get_faces().emplace_back(Face({12, 7, 11}));
+    icosahedron.add_triangle(1, 2, 3);
+    icosahedron.add_triangle(1, 3, 4);
+    icosahedron.add_triangle(1, 4, 5);
+    icosahedron.add_triangle(1, 5, 6);
+    icosahedron.add_triangle(1, 6, 2);
+    icosahedron.add_triangle(2, 7, 3);
+    icosahedron.add_triangle(3, 7, 8);
+    icosahedron.add_triangle(3, 8, 4);
+    icosahedron.add_triangle(4, 8, 9);
+    icosahedron.add_triangle(4, 9, 5);
+    icosahedron.add_triangle(5, 9, 10);
+    icosahedron.add_triangle(5, 10, 6);
+    icosahedron.add_triangle(6, 10, 11);
+    icosahedron.add_triangle(6, 11, 2);
+    icosahedron.add_triangle(2, 11, 7);
+    icosahedron.add_triangle(12, 8, 7);
+    icosahedron.add_triangle(12, 9, 8);
+    icosahedron.add_triangle(12, 10, 9);
+    icosahedron.add_triangle(12, 11, 10);
+    icosahedron.add_triangle(12, 7, 11);
 
     icosahedron.correct_indexes();
 
@@ -125,36 +180,36 @@ Figure Platonic::dodecahedron() {
     Figure ico = icosahedron();
 
     // Traverse faces of icosahedron
-    for (const Face & i : ico.get_faces()) {
+    for (const Triangle & i : ico.get_triangles()) {
 
         // Take middle of each coordinate
-        double x = (ico.get_points()[i.get_point_indexes()[0]].x +
-                    ico.get_points()[i.get_point_indexes()[1]].x +
-                    ico.get_points()[i.get_point_indexes()[2]].x) / 3;
+        double x = (ico.get_points()[i.a].x +
+                    ico.get_points()[i.b].x +
+                    ico.get_points()[i.c].x) / 3;
 
-        double y = (ico.get_points()[i.get_point_indexes()[0]].y +
-                    ico.get_points()[i.get_point_indexes()[1]].y +
-                    ico.get_points()[i.get_point_indexes()[2]].y) / 3;
+        double y = (ico.get_points()[i.a].y +
+                    ico.get_points()[i.b].y +
+                    ico.get_points()[i.c].y) / 3;
 
-        double z = (ico.get_points()[i.get_point_indexes()[0]].z +
-                    ico.get_points()[i.get_point_indexes()[1]].z +
-                    ico.get_points()[i.get_point_indexes()[2]].z) / 3;
+        double z = (ico.get_points()[i.a].z +
+                    ico.get_points()[i.b].z +
+                    ico.get_points()[i.c].z) / 3;
 
         dodecahedron.add_point_double(std::make_tuple(x,y,z));
     }
 
-    dodecahedron.get_faces().emplace_back(Face({1,2,3,4,5}));
-    dodecahedron.get_faces().emplace_back(Face({1,6,7,8,2}));
-    dodecahedron.get_faces().emplace_back(Face({2,8,9,10,3}));
-    dodecahedron.get_faces().emplace_back(Face({3,10,11,12,4}));
-    dodecahedron.get_faces().emplace_back(Face({4,12,13,14,5}));
-    dodecahedron.get_faces().emplace_back(Face({5,14,15,6,1}));
-    dodecahedron.get_faces().emplace_back(Face({20,19,18,17,16}));
-    dodecahedron.get_faces().emplace_back(Face({20,15,14,13,19}));
-    dodecahedron.get_faces().emplace_back(Face({19,13,12,11,18}));
-    dodecahedron.get_faces().emplace_back(Face({18,11,10,9,17}));
-    dodecahedron.get_faces().emplace_back(Face({17,9,8,7,16}));
-    dodecahedron.get_faces().emplace_back(Face({16,7,6,15,20}));
+    dodecahedron.add_face({1,2,3,4,5});
+    dodecahedron.add_face({1,6,7,8,2});
+    dodecahedron.add_face({2,8,9,10,3});
+    dodecahedron.add_face({3,10,11,12,4});
+    dodecahedron.add_face({4,12,13,14,5});
+    dodecahedron.add_face({5,14,15,6,1});
+    dodecahedron.add_face({20,19,18,17,16});
+    dodecahedron.add_face({20,15,14,13,19});
+    dodecahedron.add_face({19,13,12,11,18});
+    dodecahedron.add_face({18,11,10,9,17});
+    dodecahedron.add_face({17,9,8,7,16});
+    dodecahedron.add_face({16,7,6,15,20});
 
     dodecahedron.correct_indexes();
     return dodecahedron;
@@ -162,58 +217,51 @@ Figure Platonic::dodecahedron() {
 
 void Platonic::create_triangles(Figure &ico) {
 
-    // Store new faces for sphere
-    std::vector<Face> faces;
+    // Store new faces for sphere, every triangle is split up in 4
+    std::vector<Triangle> faces;
+    faces.reserve(4 * ico.get_triangles().size());
+    // Every edge is shared by 2 triangles, its midpoint is only added once
+    ico.get_points().reserve(ico.get_points().size() + 3 * ico.get_triangles().size() / 2);
+    MidpointCache midpoints(3 * ico.get_triangles().size() / 2);
 
-    for (Face & i : ico.get_faces()) {
+    // Get index of the midpoint of edge ab, add it if it does not exist yet
+    auto midpoint = [&ico, &midpoints](const int a, const int b) {
+        const std::size_t slot = midpoints.find(a, b);
+        if (!midpoints.empty(slot)) return midpoints.get(slot);
 
-        // Triangle "ABC"
-        Vector3D & a = ico.get_points()[i.get_point_indexes()[0]];
-        Vector3D & b = ico.get_points()[i.get_point_indexes()[1]];
-        Vector3D & c = ico.get_points()[i.get_point_indexes()[2]];
+        const int x = static_cast<int>(ico.get_points().size());
+        const Vector3D p = ico.get_points()[a];
+        const Vector3D q = ico.get_points()[b];
+        ico.get_points().push_back(Vector3D::point((p.x + q.x) / 2, (p.y + q.y) / 2, (p.z + q.z) / 2));
+        midpoints.set(slot, a, b, x);
+        return x;
+    };
 
-        // Calculate points D, E, F
-        Vector3D d = Vector3D::point( (a.x + b.x) / 2,
-                                      (a.y + b.y) / 2,
-                                      (a.z + b.z) / 2 );
-
-        Vector3D e = Vector3D::point( (a.x + c.x) / 2,
-                                     (a.y + c.y) / 2,
-                                     (a.z + c.z) / 2 );
-
-        Vector3D f = Vector3D::point( (c.x + b.x) / 2,
-                                     (c.y + b.y) / 2,
-                                     (c.z + b.z) / 2 );
-
-        // Push back points D, E, F
-        ico.get_points().push_back(d);
-        ico.get_points().push_back(e);
-        ico.get_points().push_back(f);
+    for (const Triangle & i : ico.get_triangles()) {
 
         // Get face_indexes off points A, B, C
-        const int A = i.get_point_indexes()[0];
-        const int B = i.get_point_indexes()[1];
-        const int C = i.get_point_indexes()[2];
+        const int A = i.a;
+        const int B = i.b;
+        const int C = i.c;
 
-        // Get face_indexes off points D, F, E
-        const int D = ico.get_points().size()-3;
-        const int E = ico.get_points().size()-2;
-        const int F = ico.get_points().size()-1;
+        // Get face_indexes off points D, E, F
+        const int D = midpoint(A, B);
+        const int E = midpoint(A, C);
+        const int F = midpoint(B, C);
 
         // Add triangles to faces
 
         // ADE
-        faces.emplace_back(Face({A,D,E}));
+        faces.push_back(Triangle{A,D,E});
         // BFD
-        faces.emplace_back(Face({B,F,D}));
+        faces.push_back(Triangle{B,F,D});
         // CEF
-        faces.emplace_back(Face({C,E,F}));
+        faces.push_back(Triangle{C,E,F});
         // DFE
-        faces.emplace_back(Face({D,F,E}));
+        faces.push_back(Triangle{D,F,E});
     }
 
-    ico.clear_faces();
-    ico.get_faces() = faces;
+    ico.get_triangles().swap(faces);
 }
 
 Figure Platonic::sphere(const int &n) {
@@ -224,8 +272,8 @@ Figure Platonic::sphere(const int &n) {
         Platonic::create_triangles(sphere);
     }
     // Rescale
-    for (Vector3D & i : sphere.get_points()) {
-        i.normalise();
+    for (unsigned int i = 0; i != sphere.get_points().size(); i++) {
+        sphere.get_points().set(i, Vector3D::normalise(sphere.get_points()[i]));
     }
     return sphere;
 }
@@ -246,7 +294,7 @@ Figure Platonic::cone(const int &n, const double &h) {
 
     // 0 - n faces (from ground to top)
     for (int i = 0; i != n; i++) {
-        cone.get_faces().emplace_back(Face({n, i % n, (i + 1) % n}));
+        cone.add_face({n, i % n, (i + 1) % n});
     }
 
     return cone;
@@ -271,22 +319,22 @@ Figure Platonic::cylinder(const int &n, const double &h) {
 
     // Rectangles faces
     for (int i = 0; i != n; i++) {
-        cylinder.get_faces().emplace_back(Face({i, (i + 1) % n,
+        cylinder.add_face({i, (i + 1) % n,
                                                 ((i + 1) % n) + n,
-                                                i + n}));
+                                                i + n});
     }
 
     std::vector<int> ceiling;
     for (int i = 0; i < n; i++) {
         ceiling.emplace_back(i);
     }
-    cylinder.get_faces().emplace_back(Face(ceiling));
+    cylinder.add_face(ceiling);
 
     std::vector<int> ground;
     for (int i = n; i < 2 * n; i++) {
         ground.emplace_back(i);
     }
-    cylinder.get_faces().emplace_back(Face(ground));
+    cylinder.add_face(ground);
 
     return cylinder;
 }
@@ -312,12 +360,31 @@ Figure Platonic::torus(const double &r, const double &R, const int &n, const int
             const int a3 = (i + 1) % n * m + (j + 1) % m;
             const int a4 = i * m + (j + 1) % m;
 
-            torus.get_faces().emplace_back(Face({a1, a2, a3, a4}));
+            torus.add_face({a1, a2, a3, a4});
         }
     }
     return torus;
 }
 
+int Platonic::sphere_level(const double &radius, const double &edge) {
+
+    // Edges of an icosahedron on the unit sphere are 1.0515 long, every subdivision halves them
+    double length = 1.0515 * radius;
+    int n = 0;
+    while (length > edge && n != MAX_SPHERE_LEVEL) {
+        length /= 2;
+        n++;
+    }
+    return n;
+}
+
+int Platonic::circle_segments(const double &radius, const double &edge) {
+
+    const double segments = std::ceil(2 * M_PI * radius / edge);
+    if (!(segments > 3)) return 3;
+    return segments < MAX_CIRCLE_SEGMENTS ? static_cast<int>(segments) : MAX_CIRCLE_SEGMENTS;
+}
+
 Figure Platonic::buckyBall() {
 
     Figure buckyBall = Platonic::icosahedron();
@@ -12,6 +12,22 @@
  */
 namespace Platonic {
 
+    /**
+     * \brief Highest amount of subdivisions a Sphere with an automatic level of detail gets
+     */
+    const int MAX_SPHERE_LEVEL = 8;
+
+    /**
+     * \brief Highest amount of segments a circle of a primitive with an automatic level of detail gets
+     */
+    const int MAX_CIRCLE_SEGMENTS = 1024;
+
+    /**
+     * \brief Subdivisions of the Sphere and segments of the circles an automatic level of detail is chosen from
+     */
+    const int COARSE_SPHERE_LEVEL = 1;
+    const int COARSE_CIRCLE_SEGMENTS = 16;
+
     /**
      * \brief Generate cube
      *
@@ -48,7 +64,8 @@ namespace Platonic {
     Figure dodecahedron();
 
     /**
-     * \brief Split up a Icosahedron up in triangles to generate a sphere-like figure
+     * \brief Split up a Icosahedron up in triangles to generate a sphere-like figure, the midpoint of an edge is
+     * shared by both triangles of that edge
      *
      * @param ico Takes a Icosahedron as Figure
      */
@@ -95,6 +112,26 @@ namespace Platonic {
      */
     Figure torus(const double &r, const double &R, const int &n, const int &m);
 
+    /**
+     * \brief Get smallest amount of subdivisions that keeps the edges of a Sphere at most edge long
+     *
+     * @param radius Radius of the Sphere in pixels
+     * @param edge Target length of an edge in pixels
+     *
+     * @return Amount of subdivisions, between 0 and MAX_SPHERE_LEVEL
+     */
+    int sphere_level(const double &radius, const double &edge);
+
+    /**
+     * \brief Get smallest amount of segments that keeps the segments of a circle at most edge long
+     *
+     * @param radius Radius of the circle in pixels
+     * @param edge Target length of a segment in pixels
+     *
+     * @return Amount of segments, between 3 and MAX_CIRCLE_SEGMENTS
+     */
+    int circle_segments(const double &radius, const double &edge);
+
     /**
      * \brief Creates not a buckeyBall but a icosahedron
      *
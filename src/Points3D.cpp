@@ -0,0 +1,24 @@
+//
+// Created by Pablo Deputter on 07/05/2021.
+//
+
+#include "Points3D.h"
+
+void Points3D::transform(const Matrix &x) {
+
+    Transform::transform_points(xs.data(), ys.data(), zs.data(), size(), x);
+}
+
+void Points3D::transform_project(const Matrix &x, const double d, std::vector<double> &projected_x,
+                                 std::vector<double> &projected_y, Transform::Bounds *bounds) {
+
+    projected_x.resize(size());
+    projected_y.resize(size());
+    Transform::transform_project(xs.data(), ys.data(), zs.data(), size(), x, d,
+                                 projected_x.data(), projected_y.data(), bounds);
+}
+
+void Points3D::transform_bounds(const Matrix &x, const double d, Transform::Bounds &bounds) {
+
+    Transform::transform_project(xs.data(), ys.data(), zs.data(), size(), x, d, nullptr, nullptr, &bounds);
+}
@@ -0,0 +1,126 @@
+//
+// Created by Pablo Deputter on 07/05/2021.
+//
+
+#ifndef ENGINE_POINTS3D_H
+#define ENGINE_POINTS3D_H
+
+#include <vector>
+#include "vector3d.h"
+#include "Transform.h"
+
+/**
+ * @brief The Points3D class, stores the points of a Figure as separate x, y and z arrays
+ *
+ * Points are read and written as Vector3D values, the arrays themselves are handed to the batch kernels of Transform.
+ */
+class Points3D {
+
+private:
+    /**
+     * @brief x-coordinates
+     */
+    std::vector<double> xs;
+    /**
+     * @brief y-coordinates
+     */
+    std::vector<double> ys;
+    /**
+     * @brief z-coordinates
+     */
+    std::vector<double> zs;
+public:
+    std::size_t size() const {
+        return xs.size();
+    }
+
+    bool empty() const {
+        return xs.empty();
+    }
+
+    void reserve(const std::size_t n) {
+        xs.reserve(n);
+        ys.reserve(n);
+        zs.reserve(n);
+    }
+
+    void clear() {
+        xs.clear();
+        ys.clear();
+        zs.clear();
+    }
+
+    void push_back(const Vector3D &x) {
+        xs.push_back(x.x);
+        ys.push_back(x.y);
+        zs.push_back(x.z);
+    }
+
+    void emplace_back(const Vector3D &x) {
+        push_back(x);
+    }
+
+    /**
+     * @brief Get point i
+     *
+     * @return Point as Vector3D object
+     */
+    Vector3D operator[](const std::size_t i) const {
+        return Vector3D::point(xs[i], ys[i], zs[i]);
+    }
+
+    /**
+     * @brief Overwrite point i
+     */
+    void set(const std::size_t i, const Vector3D &x) {
+        xs[i] = x.x;
+        ys[i] = x.y;
+        zs[i] = x.z;
+    }
+
+    double *x_data() {
+        return xs.data();
+    }
+
+    double *y_data() {
+        return ys.data();
+    }
+
+    double *z_data() {
+        return zs.data();
+    }
+
+    const double *x_data() const {
+        return xs.data();
+    }
+
+    const double *y_data() const {
+        return ys.data();
+    }
+
+    const double *z_data() const {
+        return zs.data();
+    }
+
+    /**
+     * @brief Multiply every point with matrix x
+     */
+    void transform(const Matrix &x);
+
+    /**
+     * @brief Multiply every point with matrix x and project it on the plane z = -d in the same pass
+     *
+     * @param projected_x Output for the projected x-coordinates, resized to size()
+     * @param projected_y Output for the projected y-coordinates, resized to size()
+     * @param bounds Widened with the projected points, may be nullptr
+     */
+    void transform_project(const Matrix &x, const double d, std::vector<double> &projected_x,
+                           std::vector<double> &projected_y, Transform::Bounds *bounds = nullptr);
+
+    /**
+     * @brief Multiply every point with matrix x and widen bounds with its projection on the plane z = -d
+     */
+    void transform_bounds(const Matrix &x, const double d, Transform::Bounds &bounds);
+};
+
+#endif //ENGINE_POINTS3D_H
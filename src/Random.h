@@ -0,0 +1,45 @@
+//
+// Created by Pablo Deputter on 11/05/2021.
+//
+
+#ifndef ENGINE_RANDOM_H
+#define ENGINE_RANDOM_H
+
+#include <cstdint>
+
+/**
+ * @brief Namespace holding a counter-based random generator, every random value is a hash of a key
+ *
+ * A value only depends on its key and not on the values drawn before it, so work that is split over threads or walked
+ * in another order draws the same values.
+ */
+namespace Random {
+
+    /**
+     * @brief Finalizer of SplitMix64, scatters every bit of x over the result
+     *
+     * @param x Key
+     *
+     * @return Random value as uint64_t
+     */
+    inline uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    /**
+     * @brief Get key of child index of the node with given key, e.g. symbol index of the replacement of a symbol
+     *
+     * @param key Key of the parent
+     * @param index Index of the child
+     *
+     * @return Key as uint64_t
+     */
+    inline uint64_t child(const uint64_t key, const uint64_t index) {
+        return mix(key + (index + 1) * 0x9E3779B97F4A7C15ull);
+    }
+}
+
+#endif //ENGINE_RANDOM_H
@@ -0,0 +1,124 @@
+//
+// Created by Pablo Deputter on 03/05/2021.
+//
+
+#include "Stats.h"
+#include "Trace.h"
+
+namespace {
+    bool stats_enabled = false;
+    Stats::Counters stats_counters;
+    std::vector<Stats::Lod> stats_lods;
+    double stats_times[Stats::NR_STAGES] = {};
+
+    std::string escape(const std::string &x) {
+        std::string escaped;
+        for (const char &i : x) {
+            if (i == '"' || i == '\\') escaped += '\\';
+            escaped += i;
+        }
+        return escaped;
+    }
+}
+
+void Stats::set_enabled(const bool &x) {
+    stats_enabled = x;
+}
+
+bool Stats::enabled() {
+    return stats_enabled;
+}
+
+void Stats::reset() {
+
+    stats_counters = Counters();
+    stats_lods.clear();
+    for (double &i : stats_times) {
+        i = 0;
+    }
+}
+
+Stats::Counters &Stats::counters() {
+    return stats_counters;
+}
+
+std::vector<Stats::Lod> &Stats::lods() {
+    return stats_lods;
+}
+
+void Stats::add_time(const Stage &stage, const double &seconds) {
+    stats_times[stage] += seconds;
+}
+
+const char *Stats::stage_name(const Stage &stage) {
+
+    switch (stage) {
+        case LSYSTEM: return "lsystem";
+        case GENERATE_FIGURES: return "generate_figures";
+        case FRACTAL: return "fractal";
+        case PREP_ZBUFFERING: return "prep_zbuffering";
+        case SHADOW_MASK: return "shadow_mask";
+        case RASTERIZE: return "rasterize";
+        case ENCODE: return "encode";
+        default: return "unknown";
+    }
+}
+
+void Stats::write_json(std::ostream &out, const std::string &input_file) {
+
+    const Counters &c = stats_counters;
+
+    // Stages are inclusive, "fractal" is also part of "generate_figures"
+    out << "{\n";
+    out << "  \"input\": \"" << escape(input_file) << "\",\n";
+    out << "  \"stages_ms\": {\n";
+    for (int i = 0; i != NR_STAGES; i++) {
+        out << "    \"" << stage_name(static_cast<Stage>(i)) << "\": " << stats_times[i] * 1000.0
+            << (i + 1 != NR_STAGES ? ",\n" : "\n");
+    }
+    out << "  },\n";
+
+    double pass_rate = c.pixels_tested != 0 ? static_cast<double>(c.pixels_passed) / c.pixels_tested : 0.0;
+
+    out << "  \"counters\": {\n";
+    out << "    \"triangles_submitted\": " << c.triangles_submitted << ",\n";
+    out << "    \"triangles_culled\": " << c.triangles_culled << ",\n";
+    out << "    \"pixels_tested\": " << c.pixels_tested << ",\n";
+    out << "    \"pixels_passed\": " << c.pixels_passed << ",\n";
+    out << "    \"depth_test_pass_rate\": " << pass_rate << ",\n";
+    out << "    \"lights_evaluated\": " << c.lights_evaluated << ",\n";
+    out << "    \"lsystem_symbols\": " << c.lsystem_symbols << ",\n";
+    out << "    \"mesh_cache_hits\": " << c.mesh_cache_hits << ",\n";
+    out << "    \"mesh_cache_misses\": " << c.mesh_cache_misses << ",\n";
+    out << "    \"lsystem_cache_hits\": " << c.lsystem_cache_hits << ",\n";
+    out << "    \"lsystem_cache_misses\": " << c.lsystem_cache_misses << ",\n";
+    out << "    \"bytes_written\": " << c.bytes_written << "\n";
+    out << "  },\n";
+
+    out << "  \"lod\": [";
+    for (std::size_t i = 0; i != stats_lods.size(); i++) {
+        out << (i != 0 ? ",\n" : "\n") << "    {\"figure\": \"" << escape(stats_lods[i].figure) << "\", \"level\": \""
+            << escape(stats_lods[i].level) << "\", \"pixels\": " << stats_lods[i].pixels << "}";
+    }
+    out << (stats_lods.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+}
+
+Stats::ScopedTimer::ScopedTimer(const Stage &stage) : stage(stage), active(stats_enabled || Trace::enabled()) {
+
+    if (active) start = std::chrono::steady_clock::now();
+}
+
+Stats::ScopedTimer::~ScopedTimer() {
+    stop();
+}
+
+void Stats::ScopedTimer::stop() {
+
+    if (!active) return;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    if (stats_enabled) add_time(stage, elapsed.count());
+    Trace::add_span(stage_name(stage), start, end);
+    active = false;
+}
@@ -0,0 +1,200 @@
+//
+// Created by Pablo Deputter on 03/05/2021.
+//
+
+#ifndef ENGINE_STATS_H
+#define ENGINE_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Namespace holding the per-stage timers and counters of a render
+ *
+ * Counters are plain integers that hot loops accumulate locally and flush once per primitive, timers are only read
+ * when Stats are enabled. When disabled the only cost left is a branch per stage.
+ */
+namespace Stats {
+
+    /**
+     * @brief Stages of the render pipeline that are timed
+     */
+    enum Stage {
+        LSYSTEM = 0,
+        GENERATE_FIGURES,
+        FRACTAL,
+        PREP_ZBUFFERING,
+        SHADOW_MASK,
+        RASTERIZE,
+        ENCODE,
+        NR_STAGES
+    };
+
+    /**
+     * @brief Counters gathered during a render
+     */
+    struct Counters {
+        /**
+         * @brief Triangles handed to the rasterizer
+         */
+        uint64_t triangles_submitted = 0;
+        /**
+         * @brief Triangles that did not cover a single scanline
+         */
+        uint64_t triangles_culled = 0;
+        /**
+         * @brief Pixels of which the z-value was compared against the ZBuffer
+         */
+        uint64_t pixels_tested = 0;
+        /**
+         * @brief Pixels that passed the depth-test and were shaded
+         */
+        uint64_t pixels_passed = 0;
+        /**
+         * @brief Evaluations of a light for a single pixel
+         */
+        uint64_t lights_evaluated = 0;
+        /**
+         * @brief Symbols of expanded L-system strings interpreted by the turtle
+         */
+        uint64_t lsystem_symbols = 0;
+        /**
+         * @brief Primitive meshes taken from the MeshCache
+         */
+        uint64_t mesh_cache_hits = 0;
+        /**
+         * @brief Primitive meshes that had to be generated
+         */
+        uint64_t mesh_cache_misses = 0;
+        /**
+         * @brief Lines of deterministic L-systems taken from the LSystemCache, in memory or on disk
+         */
+        uint64_t lsystem_cache_hits = 0;
+        /**
+         * @brief Lines of deterministic L-systems that had to be drawn
+         */
+        uint64_t lsystem_cache_misses = 0;
+        /**
+         * @brief Bytes written to the output image
+         */
+        uint64_t bytes_written = 0;
+    };
+
+    /**
+     * @brief Tessellation chosen for a figure with an automatic level of detail
+     */
+    struct Lod {
+        /**
+         * @brief Name of the figure in the .ini file
+         */
+        std::string figure;
+        /**
+         * @brief Chosen parameters of the generator, e.g. "n=4"
+         */
+        std::string level;
+        /**
+         * @brief Projected size of the figure in pixels
+         */
+        double pixels;
+    };
+
+    /**
+     * @brief Enable or disable gathering of stats
+     *
+     * @param x bool
+     */
+    void set_enabled(const bool &x);
+
+    /**
+     * @brief Check if stats are gathered
+     *
+     * @return true if enabled
+     */
+    bool enabled();
+
+    /**
+     * @brief Reset all timers and counters, called before every render
+     */
+    void reset();
+
+    /**
+     * @brief Get counters of current render
+     *
+     * @return Counters by reference
+     */
+    Counters &counters();
+
+    /**
+     * @brief Get levels of detail chosen during current render
+     *
+     * @return List by reference, one entry per figure with lod = auto
+     */
+    std::vector<Lod> &lods();
+
+    /**
+     * @brief Add time spent in stage
+     *
+     * @param stage Stage of pipeline
+     * @param seconds Wall time in seconds
+     */
+    void add_time(const Stage &stage, const double &seconds);
+
+    /**
+     * @brief Get name of stage as used in the JSON output
+     *
+     * @param stage Stage of pipeline
+     *
+     * @return Name as C-string
+     */
+    const char *stage_name(const Stage &stage);
+
+    /**
+     * @brief Write timers and counters of current render as JSON
+     *
+     * @param out Output stream
+     * @param input_file Name of .ini file that was rendered
+     */
+    void write_json(std::ostream &out, const std::string &input_file);
+
+    /**
+     * @brief Adds the wall time between construction and destruction to a stage, also recorded as a Trace span
+     */
+    class ScopedTimer {
+    private:
+        /**
+         * @brief Stage the time is added to
+         */
+        Stage stage;
+        /**
+         * @brief Were stats enabled at construction
+         */
+        bool active;
+        /**
+         * @brief Moment of construction
+         */
+        std::chrono::steady_clock::time_point start;
+    public:
+        /**
+         * @brief Constructor for ScopedTimer object
+         *
+         * @param stage Stage to be timed
+         */
+        explicit ScopedTimer(const Stage &stage);
+
+        ~ScopedTimer();
+
+        /**
+         * @brief Add the time until now to the stage before going out of scope
+         */
+        void stop();
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+    };
+}
+
+#endif //ENGINE_STATS_H
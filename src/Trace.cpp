@@ -0,0 +1,127 @@
+//
+// Created by Pablo Deputter on 04/05/2021.
+//
+
+#include "Trace.h"
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+    struct Event {
+        std::string name;
+        double ts;
+        double dur;
+        int tid;
+    };
+
+    std::mutex trace_mutex;
+    std::atomic<bool> trace_enabled(false);
+    std::string trace_file;
+    std::chrono::steady_clock::time_point trace_start;
+    std::vector<Event> trace_events;
+    std::vector<std::pair<int, std::string>> trace_threads;
+    std::atomic<int> trace_next_tid(0);
+
+    /**
+     * @brief Lane of the calling thread, -1 until it records something
+     */
+    thread_local int trace_tid = -1;
+
+    int thread_id() {
+        if (trace_tid == -1) trace_tid = trace_next_tid++;
+        return trace_tid;
+    }
+
+    double to_us(const std::chrono::steady_clock::time_point &x) {
+        return std::chrono::duration<double, std::micro>(x - trace_start).count();
+    }
+
+    void write_string(std::ostream &out, const std::string &x) {
+        out << '"';
+        for (const char &i : x) {
+            if (i == '"' || i == '\\') out << '\\';
+            out << i;
+        }
+        out << '"';
+    }
+}
+
+void Trace::open(const std::string &file_name) {
+
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    trace_file = file_name;
+    trace_start = std::chrono::steady_clock::now();
+    trace_events.clear();
+    trace_threads.clear();
+    // Make sure the opening thread becomes lane 0
+    trace_threads.emplace_back(thread_id(), "main");
+    trace_enabled = true;
+}
+
+bool Trace::close() {
+
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (!trace_enabled) return true;
+    trace_enabled = false;
+
+    std::ofstream out(trace_file, std::ios::trunc | std::ios::out);
+    if (!out) return false;
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"engine\"}}";
+    for (const std::pair<int, std::string> &i : trace_threads) {
+        out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i.first
+            << ", \"args\": {\"name\": ";
+        write_string(out, i.second);
+        out << "}}";
+    }
+    for (const Event &i : trace_events) {
+        out << ",\n{\"name\": ";
+        write_string(out, i.name);
+        out << ", \"cat\": \"render\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << i.tid
+            << ", \"ts\": " << i.ts << ", \"dur\": " << i.dur << "}";
+    }
+    out << "\n]}\n";
+    trace_events.clear();
+    return static_cast<bool>(out);
+}
+
+bool Trace::enabled() {
+    return trace_enabled;
+}
+
+void Trace::set_thread_name(const std::string &name) {
+
+    if (!trace_enabled) return;
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    for (const std::pair<int, std::string> &i : trace_threads) {
+        if (i.second != name) continue;
+        trace_tid = i.first;
+        return;
+    }
+    trace_threads.emplace_back(thread_id(), name);
+}
+
+void Trace::add_span(const std::string &name, const std::chrono::steady_clock::time_point &start,
+                     const std::chrono::steady_clock::time_point &end) {
+
+    if (!trace_enabled) return;
+    int tid = thread_id();
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    trace_events.push_back(Event{name, to_us(start), to_us(end) - to_us(start), tid});
+}
+
+Trace::Span::Span(const std::string &name) : active(trace_enabled) {
+
+    if (!active) return;
+    this->name = name;
+    start = std::chrono::steady_clock::now();
+}
+
+Trace::Span::~Span() {
+
+    if (active) add_span(name, start, std::chrono::steady_clock::now());
+}
@@ -0,0 +1,92 @@
+//
+// Created by Pablo Deputter on 04/05/2021.
+//
+
+#ifndef ENGINE_TRACE_H
+#define ENGINE_TRACE_H
+
+#include <chrono>
+#include <string>
+
+/**
+ * @brief Namespace holding a timeline recorder that is written in the Chrome Trace Event Format
+ *
+ * The written file can be opened in chrome://tracing or ui.perfetto.dev. Every thread that records a span gets its
+ * own lane, the thread that opened the trace is lane 0.
+ */
+namespace Trace {
+
+    /**
+     * @brief Start recording spans, these are written to file_name by close()
+     *
+     * @param file_name Name of the output file
+     */
+    void open(const std::string &file_name);
+
+    /**
+     * @brief Write all recorded spans and stop recording
+     *
+     * @return false if the output file could not be written
+     */
+    bool close();
+
+    /**
+     * @brief Check if spans are recorded
+     *
+     * @return true if a trace is open
+     */
+    bool enabled();
+
+    /**
+     * @brief Give the lane of the calling thread a name, threads with the same name share a lane
+     *
+     * Short-lived threads that do the same job, like the workers of Parallel::for_range, so stay on one lane.
+     *
+     * @param name Name of the thread
+     */
+    void set_thread_name(const std::string &name);
+
+    /**
+     * @brief Record a finished span on the lane of the calling thread
+     *
+     * @param name Name of the span
+     * @param start Moment the span started
+     * @param end Moment the span ended
+     */
+    void add_span(const std::string &name, const std::chrono::steady_clock::time_point &start,
+                  const std::chrono::steady_clock::time_point &end);
+
+    /**
+     * @brief Records the time between construction and destruction as a span
+     */
+    class Span {
+    private:
+        /**
+         * @brief Name of the span
+         */
+        std::string name;
+        /**
+         * @brief Was a trace open at construction
+         */
+        bool active;
+        /**
+         * @brief Moment of construction
+         */
+        std::chrono::steady_clock::time_point start;
+    public:
+        /**
+         * @brief Constructor for Span object
+         *
+         * @param name Name of the span
+         */
+        explicit Span(const std::string &name);
+
+        ~Span();
+
+        Span(const Span &) = delete;
+
+        Span &operator=(const Span &) = delete;
+    };
+}
+
+#endif //ENGINE_TRACE_H
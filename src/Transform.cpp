@@ -0,0 +1,176 @@
+//
+// Created by Pablo Deputter on 07/05/2021.
+//
+
+#include "Transform.h"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+    /**
+     * @brief Coefficients of a point transformation, x' = 0 + x * xx + y * yx + z * zx + tx
+     */
+    struct Coefficients {
+        double xx, xy, xz;
+        double yx, yy, yz;
+        double zx, zy, zz;
+        double tx, ty, tz;
+
+        explicit Coefficients(const Matrix &m) : xx(m(1, 1)), xy(m(1, 2)), xz(m(1, 3)),
+                                                 yx(m(2, 1)), yy(m(2, 2)), yz(m(2, 3)),
+                                                 zx(m(3, 1)), zy(m(3, 2)), zz(m(3, 3)),
+                                                 tx(m(4, 1)), ty(m(4, 2)), tz(m(4, 3)) {}
+    };
+
+    /**
+     * @brief Transform a single point, same order of operations as Vector3D::operator*=
+     */
+    inline void transform_scalar(double &x, double &y, double &z, const Coefficients &c) {
+
+        const double a = x;
+        const double b = y;
+        const double e = z;
+        x = 0.0 + a * c.xx + b * c.yx + e * c.zx + c.tx;
+        y = 0.0 + a * c.xy + b * c.yy + e * c.zy + c.ty;
+        z = 0.0 + a * c.xz + b * c.yz + e * c.zz + c.tz;
+    }
+
+#if defined(__AVX__)
+    const std::size_t LANES = 4;
+
+    typedef __m256d Register;
+
+    inline Register load(const double *x) { return _mm256_loadu_pd(x); }
+    inline void store(double *x, const Register &r) { _mm256_storeu_pd(x, r); }
+    inline Register set(const double x) { return _mm256_set1_pd(x); }
+    inline Register add(const Register &a, const Register &b) { return _mm256_add_pd(a, b); }
+    inline Register mul(const Register &a, const Register &b) { return _mm256_mul_pd(a, b); }
+    inline Register div(const Register &a, const Register &b) { return _mm256_div_pd(a, b); }
+    inline Register neg(const Register &a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+    inline Register min(const Register &a, const Register &b) { return _mm256_min_pd(a, b); }
+    inline Register max(const Register &a, const Register &b) { return _mm256_max_pd(a, b); }
+#elif defined(__SSE2__)
+    const std::size_t LANES = 2;
+
+    typedef __m128d Register;
+
+    inline Register load(const double *x) { return _mm_loadu_pd(x); }
+    inline void store(double *x, const Register &r) { _mm_storeu_pd(x, r); }
+    inline Register set(const double x) { return _mm_set1_pd(x); }
+    inline Register add(const Register &a, const Register &b) { return _mm_add_pd(a, b); }
+    inline Register mul(const Register &a, const Register &b) { return _mm_mul_pd(a, b); }
+    inline Register div(const Register &a, const Register &b) { return _mm_div_pd(a, b); }
+    inline Register neg(const Register &a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+    inline Register min(const Register &a, const Register &b) { return _mm_min_pd(a, b); }
+    inline Register max(const Register &a, const Register &b) { return _mm_max_pd(a, b); }
+#endif
+
+    /**
+     * @brief Transform points [0, n), optionally project them and widen bounds, returns index of first point that
+     * was not done
+     */
+    std::size_t transform_batch(double *xs, double *ys, double *zs, const std::size_t n, const Coefficients &c,
+                                const bool project, const double d, double *projected_x, double *projected_y,
+                                Transform::Bounds *bounds) {
+#if defined(__AVX__) || defined(__SSE2__)
+        const Register zero = set(0.0);
+        const Register xx = set(c.xx), xy = set(c.xy), xz = set(c.xz);
+        const Register yx = set(c.yx), yy = set(c.yy), yz = set(c.yz);
+        const Register zx = set(c.zx), zy = set(c.zy), zz = set(c.zz);
+        const Register tx = set(c.tx), ty = set(c.ty), tz = set(c.tz);
+        const Register dd = set(d);
+
+        Register x_min = set(+std::numeric_limits<double>::infinity());
+        Register x_max = set(-std::numeric_limits<double>::infinity());
+        Register y_min = x_min;
+        Register y_max = x_max;
+
+        std::size_t i = 0;
+        for (; i + LANES <= n; i += LANES) {
+
+            const Register a = load(xs + i);
+            const Register b = load(ys + i);
+            const Register e = load(zs + i);
+
+            const Register x = add(add(add(add(zero, mul(a, xx)), mul(b, yx)), mul(e, zx)), tx);
+            const Register y = add(add(add(add(zero, mul(a, xy)), mul(b, yy)), mul(e, zy)), ty);
+            const Register z = add(add(add(add(zero, mul(a, xz)), mul(b, yz)), mul(e, zz)), tz);
+
+            store(xs + i, x);
+            store(ys + i, y);
+            store(zs + i, z);
+
+            if (project) {
+                // x' = (d * x) / -z
+                const Register minus_z = neg(z);
+                const Register px = div(mul(dd, x), minus_z);
+                const Register py = div(mul(dd, y), minus_z);
+                if (projected_x) {
+                    store(projected_x + i, px);
+                    store(projected_y + i, py);
+                }
+                if (bounds) {
+                    x_min = min(x_min, px);
+                    x_max = max(x_max, px);
+                    y_min = min(y_min, py);
+                    y_max = max(y_max, py);
+                }
+            }
+        }
+
+        if (bounds && i != 0) {
+            double lanes[4][LANES];
+            store(lanes[0], x_min);
+            store(lanes[1], x_max);
+            store(lanes[2], y_min);
+            store(lanes[3], y_max);
+            for (std::size_t j = 0; j != LANES; j++) {
+                bounds->add(lanes[0][j], lanes[2][j]);
+                bounds->add(lanes[1][j], lanes[3][j]);
+            }
+        }
+        return i;
+#else
+        (void) xs; (void) ys; (void) zs; (void) n; (void) c; (void) project; (void) d;
+        (void) projected_x; (void) projected_y; (void) bounds;
+        return 0;
+#endif
+    }
+}
+
+void Transform::transform_points(double *xs, double *ys, double *zs, const std::size_t n, const Matrix &x) {
+
+    const Coefficients c(x);
+    for (std::size_t i = transform_batch(xs, ys, zs, n, c, false, 0, nullptr, nullptr, nullptr); i != n; i++) {
+        transform_scalar(xs[i], ys[i], zs[i], c);
+    }
+}
+
+void Transform::transform_project(double *xs, double *ys, double *zs, const std::size_t n, const Matrix &x,
+                                  const double d, double *projected_x, double *projected_y, Bounds *bounds) {
+
+    const Coefficients c(x);
+    for (std::size_t i = transform_batch(xs, ys, zs, n, c, true, d, projected_x, projected_y, bounds); i != n; i++) {
+        transform_scalar(xs[i], ys[i], zs[i], c);
+        const double px = (d * xs[i]) / -zs[i];
+        const double py = (d * ys[i]) / -zs[i];
+        if (projected_x) {
+            projected_x[i] = px;
+            projected_y[i] = py;
+        }
+        if (bounds) bounds->add(px, py);
+    }
+}
+
+const char *Transform::instruction_set() {
+#if defined(__AVX__)
+    return "avx";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,88 @@
+//
+// Created by Pablo Deputter on 07/05/2021.
+//
+
+#ifndef ENGINE_TRANSFORM_H
+#define ENGINE_TRANSFORM_H
+
+#include <cstddef>
+#include <limits>
+#include "vector3d.h"
+
+/**
+ * @brief Namespace holding batch kernels that transform points stored as separate x, y and z arrays
+ *
+ * The kernels use AVX when the compiler targets it and SSE2 otherwise, every lane performs the same operations in the
+ * same order as Vector3D::operator*=, so results are identical to transforming the points one by one.
+ */
+namespace Transform {
+
+    /**
+     * @brief Bounding box of projected points, empty when constructed
+     */
+    struct Bounds {
+        double x_min = +std::numeric_limits<double>::infinity();
+        double x_max = -std::numeric_limits<double>::infinity();
+        double y_min = +std::numeric_limits<double>::infinity();
+        double y_max = -std::numeric_limits<double>::infinity();
+
+        bool empty() const {
+            return x_min > x_max;
+        }
+
+        /**
+         * @brief Widen box so it contains point (x, y)
+         */
+        void add(const double x, const double y) {
+            x_min = x < x_min ? x : x_min;
+            x_max = x > x_max ? x : x_max;
+            y_min = y < y_min ? y : y_min;
+            y_max = y > y_max ? y : y_max;
+        }
+
+        /**
+         * @brief Widen box so it contains box x
+         */
+        void add(const Bounds &x) {
+            if (x.empty()) return;
+            add(x.x_min, x.y_min);
+            add(x.x_max, x.y_max);
+        }
+    };
+
+    /**
+     * @brief Multiply n points with matrix x in place
+     *
+     * @param xs x-coordinates
+     * @param ys y-coordinates
+     * @param zs z-coordinates
+     * @param n Amount of points
+     * @param x Transformation matrix, last column must be (0, 0, 0, 1)
+     */
+    void transform_points(double *xs, double *ys, double *zs, const std::size_t n, const Matrix &x);
+
+    /**
+     * @brief Multiply n points with matrix x in place and project them on the plane z = -d in the same pass
+     *
+     * @param xs x-coordinates
+     * @param ys y-coordinates
+     * @param zs z-coordinates
+     * @param n Amount of points
+     * @param x Transformation matrix, last column must be (0, 0, 0, 1)
+     * @param d Distance of projection plane
+     * @param projected_x Output for the projected x-coordinates, nullptr if only the bounds are needed
+     * @param projected_y Output for the projected y-coordinates, nullptr if only the bounds are needed
+     * @param bounds Widened with the projected points, may be nullptr
+     */
+    void transform_project(double *xs, double *ys, double *zs, const std::size_t n, const Matrix &x, const double d,
+                           double *projected_x, double *projected_y, Bounds *bounds = nullptr);
+
+    /**
+     * @brief Name of the instruction set the kernels were compiled for
+     *
+     * @return "avx", "sse2" or "scalar"
+     */
+    const char *instruction_set();
+}
+
+#endif //ENGINE_TRANSFORM_H
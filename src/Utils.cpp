@@ -2,7 +2,10 @@
 // Created by Pablo Deputter on 27/03/2021.
 //
 
+#include <unordered_map>
 #include "Utils.h"
+#include "Trace.h"
+#include "Parallel.h"
 
 LParser::LSystem2D Utils::LSystem2D(const std::string &file_name) {
 
@@ -24,113 +27,293 @@ LParser::LSystem3D Utils::LSystem3D(const std::string &file_name) {
     return l_system;
 }
 
-void Utils::fractal(Figure &figure, Figures3D &fractal, const int iter, const double &scale, bool mengerSponge) {
+std::size_t Utils::nr_fractal_children(const FractalRule &rule) {
+    return rule.anchors + (rule.menger_sponge ? rule.anchors + 4 : 0);
+}
 
-    fractal.emplace_back(figure);
-    int i = iter;
+void Utils::fractal_children(const Points3D &points, const Instance &fig, const FractalRule &rule,
+                             Instance *children) {
 
-    while (i != 0) {
-        Figures3D fractal_new;
+    const double new_scale = fig.scale / rule.scale;
+    const double factor = fig.scale - new_scale;
 
-        for (Figure& fig : fractal) {
+    for (unsigned int j = 0; j < rule.anchors; j++) {
+        *children++ = Instance{new_scale, fig.x + factor * points[j].x, fig.y + factor * points[j].y,
+                                fig.z + factor * points[j].z};
+    }
 
-            for (unsigned int j = 0; j < fig.get_points().size(); j++) {
+    if (rule.menger_sponge) {
+        // Moved a third along an edge of the cube, towards point "index"
+        auto add_edge = [&](const unsigned int j, const unsigned int index) {
+            const Vector3D p = points[j];
+            const Vector3D q = points[index];
+            *children++ = Instance{new_scale, fig.x + factor * p.x + fig.scale * (q.x - p.x) / 3,
+                                   fig.y + factor * p.y + fig.scale * (q.y - p.y) / 3,
+                                   fig.z + factor * p.z + fig.scale * (q.z - p.z) / 3};
+        };
+
+        for (unsigned int j = 0; j < rule.anchors; j++) {
+            unsigned int index = j + 1;
+            if (j == 3) index = 0;
+            if (j == 7) index = 4;
+            add_edge(j, index);
+        }
 
-                Figure new_figure = fig;
+        for (unsigned int j = 0; j < (unsigned int) 4; j++) {
+            unsigned int index = 5;
+            if (j == 1) index -= j;
+            else if (j == 2) index += j;
+            else if (j == 3) index = 6;
+            add_edge(j, index);
+        }
+    }
+}
 
-                Matrix matrix_scale = Figure::scale_figure(1 / scale);
-                new_figure.apply_transformation(matrix_scale);
+void Utils::fractal(Figure &figure, const int iter, const double &scale, bool mengerSponge, bool stream) {
 
-                Vector3D point_i = fig.get_points()[j];
-                Vector3D point_i_ = new_figure.get_points()[j];
+    FractalRule rule;
+    rule.iterations = iter;
+    rule.scale = scale;
+    rule.menger_sponge = mengerSponge;
+    rule.anchors = static_cast<unsigned int>(figure.get_points().size());
 
-                Matrix matrix_translate = Figure::translate(point_i - point_i_);
-                new_figure.apply_transformation(matrix_translate);
+    if (stream && iter > 0) {
+        figure.get_instances().clear();
+        figure.set_fractal_rule(rule);
+        return;
+    }
 
-                fractal_new.emplace_back(new_figure);
+    // Every copy is stored as a scale and translation of the base points, child j of a copy is the copy scaled by
+    // 1 / scale around its point j
+    const Points3D &points = figure.get_points();
+    const std::size_t nr_children = Utils::nr_fractal_children(rule);
+    std::vector<Instance> fractal = {{1, 0, 0, 0}};
+
+    for (int i = iter; i != 0; i--) {
+        // Children of copy j are written to [j * nr_children, (j + 1) * nr_children), so the order does not depend
+        // on how the copies are split over threads
+        std::vector<Instance> fractal_new(fractal.size() * nr_children);
+        Parallel::for_range("fractal children", fractal.size(), 4096,
+                            [&](const std::size_t begin, const std::size_t end) {
+            for (std::size_t j = begin; j != end; j++) {
+                Utils::fractal_children(points, fractal[j], rule, fractal_new.data() + j * nr_children);
             }
+        });
+        fractal.swap(fractal_new);
+    }
+    figure.get_instances().swap(fractal);
+}
 
-            if (mengerSponge) {
-                for (unsigned int j = 0; j < fig.get_points().size(); j++) {
-
-                    Figure new_figure = fig;
-
-                    Matrix matrix_scale = fig.scale_figure(1 / scale);
-                    new_figure.apply_transformation(matrix_scale);
-
-                    Vector3D point_i = fig.get_points()[j];
-                    Vector3D point_i_ = new_figure.get_points()[j];
-                    Matrix matrix_translate = fig.translate(Vector3D::vector(point_i - point_i_));
-                    new_figure.apply_transformation(matrix_translate);
+void Utils::merge_menger_sponge(Figure &cube, const int levels) {
 
-                    int index = j + 1;
-                    if (j == 3) index = 0;
-                    if (j == 7) index = 4;
+    const Points3D corners = cube.get_points();
 
-                    Vector3D vector_translate = Vector3D::vector(Vector3D::point(fig.get_points()[j].x + (fig.get_points()[index].x - fig.get_points()[j].x) / 3,
-                                                                 fig.get_points()[j].y + (fig.get_points()[index].y - fig.get_points()[j].y) / 3,
-                                                                 fig.get_points()[j].z + (fig.get_points()[index].z - fig.get_points()[j].z) / 3) - fig.get_points()[j]);
+    // Sub-cube (i, j, k) of a sponge with side "grid" is left out if two of its coordinates have a 1 as digit on the
+    // same position in base 3
+    int grid = 1;
+    for (int i = 0; i != levels; i++) grid *= 3;
+    auto exists = [grid](int i, int j, int k) {
+        if (i < 0 || j < 0 || k < 0 || i >= grid || j >= grid || k >= grid) return false;
+        for (; i != 0 || j != 0 || k != 0; i /= 3, j /= 3, k /= 3) {
+            if ((i % 3 == 1) + (j % 3 == 1) + (k % 3 == 1) > 1) return false;
+        }
+        return true;
+    };
+
+    // Corners of the sub-cubes lie on a grid of (grid + 1)^3 points, the corners of the cube keep their index so the
+    // merged mesh can still be used as the base of a fractal
+    const int side = grid + 1;
+    std::vector<int> indexes(static_cast<std::size_t>(side) * side * side, -1);
+    Points3D points;
+    auto index = [&](const int i, const int j, const int k) {
+        int &x = indexes[(static_cast<std::size_t>(i) * side + j) * side + k];
+        if (x == -1) {
+            x = static_cast<int>(points.size());
+            points.push_back(Vector3D::point(-1 + 2.0 * i / grid, -1 + 2.0 * j / grid, -1 + 2.0 * k / grid));
+        }
+        return x;
+    };
+    for (unsigned int i = 0; i != corners.size(); i++) {
+        index(corners[i].x > 0 ? grid : 0, corners[i].y > 0 ? grid : 0, corners[i].z > 0 ? grid : 0);
+    }
 
-                    Matrix matrix_translate_ = fig.translate(vector_translate);
-                    new_figure.apply_transformation(matrix_translate_);
+    // Outward direction of every face of the cube, a face is only kept if the sub-cube on that side is missing
+    std::vector<std::vector<int>> faces;
+    std::vector<std::tuple<int, int, int>> directions;
+    for (unsigned int i = 0; i != cube.nr_faces(); i++) {
+        Face face = cube.get_face(i);
+        faces.emplace_back(face.begin(), face.end());
+        Vector3D centre = Vector3D::vector(0, 0, 0);
+        for (int j : face) centre += corners[j];
+        directions.emplace_back(static_cast<int>(std::round(centre.x / 4)), static_cast<int>(std::round(centre.y / 4)),
+                                static_cast<int>(std::round(centre.z / 4)));
+    }
 
-                    fractal_new.emplace_back(new_figure);
+    cube.clear_faces();
+    std::vector<int> merged_face;
+    for (int i = 0; i != grid; i++) {
+        for (int j = 0; j != grid; j++) {
+            for (int k = 0; k != grid; k++) {
+                if (!exists(i, j, k)) continue;
+
+                for (unsigned int l = 0; l != faces.size(); l++) {
+                    if (exists(i + std::get<0>(directions[l]), j + std::get<1>(directions[l]),
+                               k + std::get<2>(directions[l]))) continue;
+
+                    merged_face.clear();
+                    for (int m : faces[l]) {
+                        merged_face.push_back(index(i + (corners[m].x > 0), j + (corners[m].y > 0),
+                                                    k + (corners[m].z > 0)));
+                    }
+                    cube.add_face(merged_face);
                 }
+            }
+        }
+    }
+    cube.get_points() = points;
+}
 
-                for (unsigned int j = 0; j < (unsigned int) 4; j++) {
-
-                    Figure new_figure = fig;
+void Utils::for_each_instance(const Figure &figure, const Matrix &x,
+                              const std::function<void(const Matrix &)> &function) {
 
-                    Matrix matrix_scale = fig.scale_figure(1 / scale);
-                    new_figure.apply_transformation(matrix_scale);
+    const Matrix model_x = figure.get_model() * x;
+    const FractalRule &rule = figure.get_fractal_rule();
 
-                    Vector3D point_i = fig.get_points()[j];
-                    Vector3D point_i_ = new_figure.get_points()[j];
-                    Matrix matrix_translate = fig.translate(Vector3D::vector(point_i - point_i_));
-                    new_figure.apply_transformation(matrix_translate);
+    if (rule.iterations == 0) {
+        for (std::size_t i = 0; i != figure.nr_instances(); i++) {
+            function(figure.instance_transformation(i, model_x));
+        }
+        return;
+    }
 
-                    int index = 5;
-                    if (j == 1) index -= j;
-                    else if (j == 2) index += j;
-                    else if (j == 3) index = 6;
+    // Depth-first walk of the copies, level i holds the children of the copy visited on level i - 1, so only
+    // iterations * children instances are alive at once. Leaves are visited in the order Utils::fractal stores them.
+    std::vector<std::vector<Instance>> levels(rule.iterations,
+                                              std::vector<Instance>(Utils::nr_fractal_children(rule)));
+    std::vector<std::size_t> next(rule.iterations, 0);
+    Utils::fractal_children(figure.get_points(), {1, 0, 0, 0}, rule, levels[0].data());
+
+    int depth = 0;
+    while (depth >= 0) {
+        if (next[depth] == levels[depth].size()) {
+            depth--;
+            continue;
+        }
+        const Instance &instance = levels[depth][next[depth]++];
+        if (depth + 1 == rule.iterations) {
+            function(Figure::instance_transformation(instance, model_x));
+            continue;
+        }
+        Utils::fractal_children(figure.get_points(), instance, rule, levels[depth + 1].data());
+        next[depth + 1] = 0;
+        depth++;
+    }
+}
 
-                    Vector3D vector_translate = Vector3D::vector(Vector3D::point(fig.get_points()[j].x + (fig.get_points()[index].x - fig.get_points()[j].x) / 3,
-                                                                 fig.get_points()[j].y + (fig.get_points()[index].y - fig.get_points()[j].y) / 3,
-                                                                 fig.get_points()[j].z + (fig.get_points()[index].z - fig.get_points()[j].z) / 3) - fig.get_points()[j]);
+std::size_t Utils::open_edges(const Figure &figure) {
 
-                    Matrix matrix_translate_ = fig.translate(vector_translate);
-                    new_figure.apply_transformation(matrix_translate_);
+    // Directed edge a -> b, a closed mesh with consistent winding also contains b -> a exactly once
+    std::unordered_map<uint64_t, int> edges;
+    auto add = [&edges](const int a, const int b) {
+        edges[(static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32) | static_cast<uint32_t>(b)]++;
+    };
+    for (unsigned int i = 0; i != figure.nr_faces(); i++) {
+        Face face = figure.get_face(i);
+        for (unsigned int j = 0; j != face.size(); j++) add(face[j], face[(j + 1) % face.size()]);
+    }
+    for (const Triangle &i : figure.get_triangles()) {
+        add(i.a, i.b);
+        add(i.b, i.c);
+        add(i.c, i.a);
+    }
 
-                    fractal_new.emplace_back(new_figure);
-                }
-            }
-        }
-        fractal = fractal_new;
-        i -= 1;
+    std::size_t open = 0;
+    for (const std::pair<const uint64_t, int> &i : edges) {
+        const uint64_t reverse = (i.first << 32) | (i.first >> 32);
+        std::unordered_map<uint64_t, int>::const_iterator j = edges.find(reverse);
+        if (i.second != 1 || j == edges.end() || j->second != 1) open++;
     }
+    return open;
 }
 
 void Utils::triangulate_figures(Figures3D &figures) {
 
+    Trace::Span span("triangulation");
+
     for (Figure &i : figures) {
-        std::vector<Face> new_faces;
+        i.triangulate();
+    }
+}
 
-        for (Face &j : i.get_faces()) {
-            std::vector<Face> triangles = ZBuffering::triangulate(j);
-            new_faces.insert(new_faces.end(), triangles.begin(), triangles.end());
-        }
-        i.get_faces().clear();
-        i.get_faces() = new_faces;
+void Utils::draw_projected_lines(const Figures3D &figures, const Matrix &eye_matrix, const double &d,
+                                 const double &dx, const double &dy, img::EasyImage &image, ZBuffer *buffer) {
+
+    Points3D points;
+    std::vector<double> projected_x;
+    std::vector<double> projected_y;
+    for (const Figure & fig : figures) {
+
+        const img::Color color = Utils::saturate_color(fig.getAmbientReflection());
+
+        // Scale, move and round in one step
+        auto draw = [&](const int a, const int b) {
+            int x0 = static_cast<int>(std::round(projected_x[a] * d + dx));
+            int y0 = static_cast<int>(std::round(projected_y[a] * d + dy));
+            int x1 = static_cast<int>(std::round(projected_x[b] * d + dx));
+            int y1 = static_cast<int>(std::round(projected_y[b] * d + dy));
+            if (buffer) image.draw_zbuf_line(*buffer, x0, y0, points.z_data()[a], x1, y1, points.z_data()[b], color);
+            else image.draw_line(x0, y0, x1, y1, color);
+        };
+
+        Utils::for_each_instance(fig, eye_matrix, [&](const Matrix &transformation) {
+            points = fig.get_points();
+            points.transform_project(transformation, 1, projected_x, projected_y);
+
+            for (unsigned int i = 0; i != fig.nr_faces(); i++) {
+                Face face = fig.get_face(i);
+                for (unsigned int j = 0; j != face.size(); j++) {
+                    draw(face[j], face[(j + 1) % face.size()]);
+                }
+            }
+            for (const Triangle & i : fig.get_triangles()) {
+                draw(i.a, i.b);
+                draw(i.b, i.c);
+                draw(i.c, i.a);
+            }
+        });
     }
 }
 
-void Utils::generate_lines(Figures3D &figures, Lines2D &figures_lines, const Matrix &trans_matrix) {
+void Utils::draw_wireframe(const Figures3D &figures, const Matrix &eye_matrix, const int size, img::EasyImage &image,
+                           const bool &ZBuffering) {
 
-    for (Figure & fig : figures) {
+    Transform::Bounds bounds;
+    {
+        Trace::Span span("projection");
+        Points3D points;
+        for (const Figure & fig : figures) {
+            fig.project_bounds(eye_matrix, points, bounds);
+        }
+    }
+    if (bounds.empty()) return;
 
-        fig.apply_transformation(trans_matrix);
-        Lines2D figure_lines = fig.do_projection();
-        figures_lines.splice(figures_lines.end(), figure_lines);
+    // Calculate image_x, image_y, d, dx, dy
+    std::tuple<double, double, double, double, double> data = Utils::calculate_data(bounds.x_min, bounds.x_max,
+                                                                                    bounds.y_min, bounds.y_max, size);
+    double image_x = std::get<0>(data);
+    double image_y = std::get<1>(data);
+
+    // Change image dimensions
+    image.image_resize(static_cast<int>(std::round(image_x)), static_cast<int>(std::round(image_y)));
+
+    if (ZBuffering) {
+        ZBuffer buffer = ZBuffer((unsigned int)(std::round(image_x)), (unsigned int)(std::round(image_y)));
+        Utils::draw_projected_lines(figures, eye_matrix, std::get<2>(data), std::get<3>(data), std::get<4>(data),
+                                    image, &buffer);
+    }
+    else {
+        Utils::draw_projected_lines(figures, eye_matrix, std::get<2>(data), std::get<3>(data), std::get<4>(data),
+                                    image, nullptr);
     }
 }
 
@@ -162,34 +345,20 @@ std::tuple<double, double, double, double, double> Utils::calculate_data(const d
     return std::make_tuple(image_x, image_y, d, dx, dy);
 }
 
-std::tuple<double, double, double, double, double, Figures3D> Utils::prep_zbuffering(Figures3D &figures, Lines2D &figures_lines,
-                                                                                     const Matrix &trans_eye_matrix, const int size) {
-
-    figures_lines.clear();
+std::tuple<double, double, double, double, double> Utils::prep_zbuffering(const Figures3D &figures,
+                                                                          const Matrix &trans_eye_matrix, const int size) {
 
-    // Traverse figures and triangulate every face
-    Utils::triangulate_figures(figures);
+    Trace::Span span("projection");
 
-    Figures3D triangulated_figures = figures;
-
-    // Do projection and generate lines
-    Utils::generate_lines(figures, figures_lines, trans_eye_matrix);
-
-    // Calculate x-min, y-min, x-max and y-max
-    std::tuple<std::pair<double, double>, std::pair<double, double>> max_line2D = Line2D::Line2D_findMax(figures_lines);
-
-    double x = std::get<0>(max_line2D).first;
-    double y = std::get<0>(max_line2D).second;
-
-    double X = std::get<1>(max_line2D).first;
-    double Y = std::get<1>(max_line2D).second;
+    // Transform every instance to eye-coordinates and calculate x-min, y-min, x-max and y-max in the same pass
+    Transform::Bounds bounds;
+    Points3D points;
+    for (const Figure & fig : figures) {
+        fig.project_bounds(trans_eye_matrix, points, bounds);
+    }
 
     // Calculate image_x, image_y, d, dx, dy
-    std::tuple<double, double, double, double, double> data = Utils::calculate_data(x, X, y, Y, size);
-
-    return std::make_tuple(std::get<0>(data), std::get<1>(data),
-                           std::get<2>(data), std::get<3>(data),
-                           std::get<4>(data), triangulated_figures);
+    return Utils::calculate_data(bounds.x_min, bounds.x_max, bounds.y_min, bounds.y_max, size);
 }
 
 img::Color Utils::saturate_color(const cc::Color &color) {
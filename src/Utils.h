@@ -6,15 +6,23 @@
 #define ENGINE_UTILS_H
 
 #include <fstream>
+#include <functional>
 #include "Figure.h"
 #include "easy_image.h"
 #include "Platonic.h"
 #include "l_parser.h"
+#include "Transform.h"
 
 /**
  * \brief Namespace implemented to hold a variety of "helper" functions
  */
 namespace Utils {
+
+    /**
+     * @brief Iterations of a MengerSponge that are merged into a single mesh, deeper sponges are copies of that mesh
+     */
+    const int MENGER_MERGED_LEVELS = 3;
+
     /**
      * @brief Read a LSystem2D file in
      *
@@ -34,15 +42,66 @@ namespace Utils {
     LParser::LSystem3D LSystem3D(const std::string & file_name);
 
     /**
-     * \brief Generates a fractal (vector of figures) for every Platonic body implemented
+     * \brief Get amount of copies a single copy is replaced by in one iteration of the fractal-algorithm
+     *
+     * @param rule Rule of the fractal
+     *
+     * @return Amount as std::size_t
+     */
+    std::size_t nr_fractal_children(const FractalRule &rule);
+
+    /**
+     * \brief Write the copies of fig one iteration of the fractal-algorithm further to children
      *
-     * @param figure Figure to be made a fractal of
-     * @param fractal Vector of figures that holds the fractal
+     * @param points Points of the base mesh
+     * @param fig Copy to be rescaled
+     * @param rule Rule of the fractal
+     * @param children Array that holds the new copies, room for nr_fractal_children(rule) copies
+     */
+    void fractal_children(const Points3D &points, const Instance &fig, const FractalRule &rule, Instance *children);
+
+    /**
+     * \brief Generates a fractal for every Platonic body implemented, every copy of the figure is stored as an
+     * Instance of its base mesh
+     *
+     * @param figure Figure to be made a fractal of, holds the instances of the fractal afterwards
      * @param iter Amount of times the fractal-algorithm will be repeated
      * @param scale Factor that will be used to rescale the original Figure and turn it into smaller figures
      * @param mengerSponge Is the "fractal" that is gonna be generated a mengerSponge?
+     * @param stream Only store the rule of the fractal, the instances are generated while drawing
+     */
+    void fractal(Figure &figure, const int iter, const double &scale, bool mengerSponge, bool stream = false);
+
+    /**
+     * \brief Replace the mesh of a cube by a MengerSponge of given amount of iterations, built as a single mesh
+     * without the faces that two sub-cubes share since those lie inside the sponge and are never visible
+     *
+     * The corners of the cube keep their index, so the sponge can be used as the base mesh of Utils::fractal.
+     *
+     * @param cube Cube as generated by Platonic::cube
+     * @param levels Amount of iterations of the sponge
+     */
+    void merge_menger_sponge(Figure &cube, const int levels);
+
+    /**
+     * \brief Call function with the transformation of every instance of figure, composed with model * x, streamed
+     * fractals are walked depth-first so peak memory does not depend on their amount of iterations
+     *
+     * @param figure Figure to be drawn
+     * @param x Eye or light transformation matrix
+     * @param function Called once per instance
      */
-    void fractal(Figure &figure, Figures3D &fractal, const int iter, const double &scale, bool mengerSponge);
+    void for_each_instance(const Figure &figure, const Matrix &x, const std::function<void(const Matrix &)> &function);
+
+    /**
+     * @brief Count the edges of a figure that do not make it a closed mesh, an edge a -> b of a watertight mesh is
+     * used once and b -> a is used once by the neighbouring face
+     *
+     * @param figure Figure to be validated
+     *
+     * @return Amount of directed edges that break this, 0 if the mesh is watertight
+     */
+    std::size_t open_edges(const Figure &figure);
 
     /**
      * @brief Triangulate list of figures
@@ -52,13 +111,31 @@ namespace Utils {
     void triangulate_figures(Figures3D &figures);
 
     /**
-     * \brief Generate 2D lines for a list of figures
+     * \brief Draw the edges of every face of every instance of figures, every instance is brought to eye-coordinates
+     * and projected in a single pass over its points
+     *
+     * @param figures List of 3D figures
+     * @param eye_matrix Eye transformation matrix
+     * @param d Scale factor
+     * @param dx Offset in x-direction
+     * @param dy Offset in y-direction
+     * @param image Image to draw on
+     * @param buffer ZBuffer used for the edges, nullptr to draw without depth-test
+     */
+    void draw_projected_lines(const Figures3D &figures, const Matrix &eye_matrix, const double &d,
+                              const double &dx, const double &dy, img::EasyImage &image, ZBuffer *buffer);
+
+    /**
+     * \brief Fit projected figures in an image of given size and draw their edges
      *
      * @param figures List of 3D figures
-     * @param figures_lines Empty or not list with 2D lines passed by reference
-     * @param trans_matrix Transformation-matrix to apply the transformation for each Figure of figures
+     * @param eye_matrix Eye transformation matrix
+     * @param size Size of image
+     * @param image Image to draw on, resized to fit the figures
+     * @param ZBuffering Use a ZBuffer for the edges
      */
-    void generate_lines(Figures3D &figures, Lines2D &figures_lines, const Matrix &trans_matrix);
+    void draw_wireframe(const Figures3D &figures, const Matrix &eye_matrix, const int size, img::EasyImage &image,
+                        const bool &ZBuffering);
 
     /**
      * @brief Calculate data that is crucial for generating a 3D figure
@@ -75,17 +152,17 @@ namespace Utils {
                                                                       const double &Y, const int size);
 
     /**
-     * \brief Calculate every variable used in the z-buffering algorithm
+     * \brief Calculate every variable used in the z-buffering algorithm, every instance of figures is brought to
+     * eye-coordinates and projected in a single pass over its points
      *
-     * @param figures List of 3D figures
-     * @param figures_lines Empty or not list with 2D lines
-     * @param trans_eye_matrix Transformation-matrix to apply the transformation for each Figure of figures
+     * @param figures List of triangulated 3D figures
+     * @param trans_eye_matrix Eye transformation matrix
      * @param size Size of image
      *
      * @return Return std::tuple<image_x, image_y, d, dx, dy>
      */
-    std::tuple<double, double, double, double, double, Figures3D> prep_zbuffering(Figures3D &figures, Lines2D &figures_lines,
-                                                                                  const Matrix &trans_eye_matrix, const int size);
+    std::tuple<double, double, double, double, double> prep_zbuffering(const Figures3D &figures,
+                                                                       const Matrix &trans_eye_matrix, const int size);
 
     /**
      * @brief Saturate every color-value in cc::Color object x255
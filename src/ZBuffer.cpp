@@ -24,14 +24,9 @@ bool ZBuffer::check_z_value(unsigned int width, unsigned int height, const doubl
     return false;
 }
 
-std::vector<Face> ZBuffering::triangulate(const Face &face) {
+void ZBuffering::triangulate(const Face &face, std::vector<Triangle> &triangles) {
 
-    std::vector<Face> triangles;
-
-    for (unsigned int i = 1; i <= face.get_point_indexes().size() - 2; i++) {
-
-        Face face_i = Face({face.get_point_indexes()[0], face.get_point_indexes()[i], face.get_point_indexes()[i + 1]});
-        triangles.emplace_back(face_i);
+    for (unsigned int i = 1; i + 1 < face.size(); i++) {
+        triangles.push_back(Triangle{face[0], face[i], face[i + 1]});
     }
-    return triangles;
 }
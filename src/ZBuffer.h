@@ -81,13 +81,12 @@ public:
  */
 namespace ZBuffering {
 /**
-     * @brief Triangulate face
+     * @brief Triangulate face as a fan around its first point
      *
      * @param face Face object
-     *
-     * @return Vector containing triangulated face
+     * @param triangles Vector the triangles are appended to
      */
-    std::vector<Face> triangulate(const Face & face);
+    void triangulate(const Face & face, std::vector<Triangle> & triangles);
 }
 
 #endif //ENGINE_ZBUFFER_H
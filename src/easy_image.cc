@@ -23,6 +23,8 @@
 #include <tgmath.h>
 #include "unistd.h"
 #include "Light.h"
+#include "Stats.h"
+#include "DebugView.h"
 
 #ifndef le32toh
 #define le32toh(x) (x)
@@ -502,7 +504,7 @@ void img::EasyImage::draw_zbuf_triag(ZBuffer &buffer, const Vector3D &A, const V
                                      const cc::Color &diffuseReflection, const cc::Color &specularReflection,
                                      const double reflectionCoef, const Lights3D &lights, const Matrix &eye_matrix,
                                      const bool &shadow, const img::EasyImage &texture, const bool &textureFlag,
-                                     const Vector3D &origin) {
+                                     const Vector3D &origin, DebugView *debug_view) {
 
     // Project triangle ABC -> A'B'C' on real points
     Point2D A_ = Point2D((d * A.x) / -A.z + dx, (d * A.y) / -A.z + dy);
@@ -546,6 +548,14 @@ void img::EasyImage::draw_zbuf_triag(ZBuffer &buffer, const Vector3D &A, const V
     Lights3D point_lights;
     bool POINTLIGHT = false;
 
+    // Counters are kept local and flushed once per triangle
+    const uint64_t nr_lights = lights.size();
+    uint64_t pixels_tested = 0;
+    uint64_t pixels_passed = 0;
+    uint64_t lights_evaluated = 0;
+
+    if (debug_view) debug_view->begin_triangle();
+
     // Iterate over all y-values
     for (unsigned int y = static_cast<unsigned int>(ymin); y <= static_cast<unsigned int>(ymax); y++) {
 
@@ -582,6 +592,8 @@ void img::EasyImage::draw_zbuf_triag(ZBuffer &buffer, const Vector3D &A, const V
         int xl = std::round(std::min(xl_AB, std::min(xl_AC, xl_BC)) + 0.5);
         int xr = std::round(std::max(xr_AB, std::max(xr_AC, xr_BC)) + 0.5);
 
+        if (debug_view) debug_view->add_span(y, static_cast<unsigned int>(xl), static_cast<unsigned int>(xr));
+
         for (unsigned int x = static_cast<unsigned int>(xl); x != static_cast<unsigned int>(xr); x++) {
 
             double a_ = static_cast<double>(std::round(x)) - xg;
@@ -592,8 +604,15 @@ void img::EasyImage::draw_zbuf_triag(ZBuffer &buffer, const Vector3D &A, const V
 
             double z = zg + a + b;
 
+            pixels_tested++;
+            if (debug_view) debug_view->add_depth_test(x, y);
             if (buffer.check_z_value(x, y, z)) {
 
+                pixels_passed++;
+                // Counted once per pixel, color_point_lights goes over the same lights
+                lights_evaluated += nr_lights;
+                if (debug_view) debug_view->add_lights(x, y, nr_lights);
+
                 // Figure as texture
                 if (textureFlag) {
 
@@ -653,20 +672,29 @@ void img::EasyImage::draw_zbuf_triag(ZBuffer &buffer, const Vector3D &A, const V
                     if (i->isReflective()) POINTLIGHT = true;
                 }
 
-                if (POINTLIGHT) color_point_lights(lights, z, d, dx, dy, nv, x, y, reflectionCoef, new_color,
-                                                   diffuseReflection, specularReflection, shadow);
+                if (POINTLIGHT) {
+                    color_point_lights(lights, z, d, dx, dy, nv, x, y, reflectionCoef, new_color,
+                                       diffuseReflection, specularReflection, shadow, debug_view);
+                }
 
                 (*this)(x, y) = Utils::saturate_color(new_color);
             }
         }
     }
+
+    Stats::Counters &counters = Stats::counters();
+    counters.triangles_submitted++;
+    if (ymin > ymax) counters.triangles_culled++;
+    counters.pixels_tested += pixels_tested;
+    counters.pixels_passed += pixels_passed;
+    counters.lights_evaluated += lights_evaluated;
 }
 
 
 void img::EasyImage::color_point_lights(const Lights3D &lights, const double &z, const double &d, const double &dx, const double &dy,
                                         const Vector3D &nv, const unsigned int x, const unsigned int y, const double &reflectionCoef,
                                         cc::Color &color, const cc::Color &diffuseReflection,const cc::Color &specularReflection,
-                                        const bool &shadow) {
+                                        const bool &shadow, DebugView *debug_view) {
 
     double ze = static_cast<double>(1.0) / z;
     double xe = (static_cast<double>(x) - dx) * (-ze / d);
@@ -675,6 +703,7 @@ void img::EasyImage::color_point_lights(const Lights3D &lights, const double &z,
 
     for (const Light * i : lights) {
 
+        if (shadow && debug_view && i->getName() == "POINT") debug_view->add_shadow_lookup(x, y);
         if (shadow && i->checkShadowMask(point)) {
             continue;
         }
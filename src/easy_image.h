@@ -29,6 +29,7 @@
 #include "ZBuffer.h"
 
 class Light;
+class DebugView;
 
 typedef std::list<Light*> Lights3D;
 
@@ -256,12 +257,13 @@ namespace img
                                  const cc::Color &diffuseReflection, const cc::Color &specularReflection,
                                  const double reflectionCoef, const Lights3D &lights, const Matrix &eye_matrix,
                                  const bool &shadow, const img::EasyImage &texture, const bool &textureFlag,
-                                 const Vector3D &origin);
+                                 const Vector3D &origin, DebugView *debug_view = nullptr);
 
             void color_point_lights(const Lights3D &lights, const double &z, const double &d, const double &dx, const double &dy,
                                     const Vector3D &nv, const unsigned int x, const unsigned int y, const double &reflectionCoef,
                                     cc::Color &color, const cc::Color &diffuseReflection,
-                                    const cc::Color &specularReflection, const bool &shadow);
+                                    const cc::Color &specularReflection, const bool &shadow,
+                                    DebugView *debug_view = nullptr);
 
 
         /**
@@ -12,6 +12,11 @@
 #include "Utils.h"
 #include "Light.h"
 #include "Control.h"
+#include "Stats.h"
+#include "Trace.h"
+#include "MeshCache.h"
+#include "LSystemCache.h"
+#include "Estimate.h"
 
 using namespace std;
 
@@ -19,61 +24,95 @@ using namespace std;
 // find ./ -name '*.bmp' | xargs rm
 // #### - SCRIPTS - ####
 
-/**
- * @brief Generates a image off a .ini file
- *
- * @return img::EasyImage object-type
- */
-img::EasyImage generate_image(const ini::Configuration &configuration) {
-
-    // General data for every image
-    std::string type = configuration["General"]["type"].as_string_or_die();
-    int size = configuration["General"]["size"].as_int_or_die();
-    std::vector<double> bg = configuration["General"]["backgroundcolor"].as_double_tuple_or_default({0, 0, 0});
-
-    // Create new image
-    img::EasyImage image = img::EasyImage(size, size, Utils::saturate_color(cc::Color(bg)));
-
-    // 2DLSystem as type
-    if (type == "2DLSystem") {
-        Control::generate_2DLSystem(image, configuration);
-    }
-
-    else if (type == "Wireframe" || type == "ZBufferedWireframe" || type == "ZBuffering"
-             || type == "LightedZBuffering" || type == "Texture") {
-        Control::generate_3D(image, configuration);
-    }
-    return image;
-}
+// #### - FLAGS - ####
+// --stats      Write timers and counters of every render to "<name>.stats.json"
+// --trace x    Write a Chrome Trace Event Format timeline of all renders to file x
+// --mesh-cache x   Keep at most x MB of generated primitive meshes between renders, 0 disables the cache
+// --lsystem-cache x    Keep lines of deterministic L-systems in directory x between runs
+// --memory-budget x    Stream L-systems and fractals of scenes estimated above x MB, refuse them if still above
+// --dry-run    Write the estimated cost of every scene as a JSON array on stdout instead of rendering it
+// #### - FLAGS - ####
 
 int main(int argc, char const* argv[])
 {
     int retVal = 0;
+    std::vector<std::string> input_files;
+    bool dry_run = false;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if(arg == "--stats")
+        {
+            Stats::set_enabled(true);
+        }
+        else if(arg == "--trace" && i + 1 < argc)
+        {
+            Trace::open(argv[++i]);
+        }
+        else if(arg == "--mesh-cache" && i + 1 < argc)
+        {
+            MeshCache::set_capacity(std::stoul(argv[++i]) << 20);
+        }
+        else if(arg == "--lsystem-cache" && i + 1 < argc)
+        {
+            LSystemCache::set_directory(argv[++i]);
+        }
+        else if(arg == "--memory-budget" && i + 1 < argc)
+        {
+            Estimate::set_budget(static_cast<uint64_t>(std::stoull(argv[++i])) << 20);
+        }
+        else if(arg == "--dry-run")
+        {
+            dry_run = true;
+        }
+        else
+        {
+            input_files.emplace_back(arg);
+        }
+    }
+    //In a dry run stdout only holds the JSON array, names of the files go to stderr
+    std::ostream &echo = dry_run ? std::cerr : std::cout;
+    bool first_estimate = true;
+    if(dry_run)
+    {
+        std::cout << "[";
+    }
     try
     {
-        for(int i = 1; i < argc; ++i)
+        for(const std::string &input_file : input_files)
         {
             ini::Configuration conf;
             try
             {
-                std::ifstream fin(argv[i]);
-                std::cout << argv[i] << std::endl;
+                std::ifstream fin(input_file);
+                echo << input_file << std::endl;
 
                 fin >> conf;
                 fin.close();
             }
             catch(ini::ParseException& ex)
             {
-                std::cerr << "Error parsing file: " << argv[i] << ": " << ex.what() << std::endl;
+                std::cerr << "Error parsing file: " << input_file << ": " << ex.what() << std::endl;
                 retVal = 1;
                 continue;
             }
 
-            img::EasyImage image = generate_image(conf);
+            if(dry_run)
+            {
+                std::cout << (first_estimate ? "\n" : ",\n");
+                first_estimate = false;
+                Estimate::write_json(std::cout, input_file, Estimate::plan(conf));
+                continue;
+            }
+
+            Stats::reset();
+            Trace::Span render_span("render " + input_file);
+            img::EasyImage image = Control::generate_image(conf);
             if(image.get_height() > 0 && image.get_width() > 0)
             {
-                std::string fileName(argv[i]);
+                std::string fileName(input_file);
                 std::string::size_type pos = fileName.rfind('.');
+                std::string baseName = pos == std::string::npos ? fileName : fileName.substr(0,pos);
                 if(pos == std::string::npos)
                 {
                     //filename does not contain a '.' --> append a '.bmp' suffix
@@ -85,9 +124,17 @@ int main(int argc, char const* argv[])
                 }
                 try
                 {
+                    Stats::ScopedTimer timer(Stats::ENCODE);
                     std::ofstream f_out(fileName.c_str(),std::ios::trunc | std::ios::out | std::ios::binary);
                     f_out << image;
+                    Stats::counters().bytes_written += static_cast<uint64_t>(f_out.tellp());
+                    timer.stop();
 
+                    if(Stats::enabled())
+                    {
+                        std::ofstream stats_out(baseName + ".stats.json", std::ios::trunc | std::ios::out);
+                        Stats::write_json(stats_out, input_file);
+                    }
                 }
                 catch(std::exception& ex)
                 {
@@ -97,7 +144,7 @@ int main(int argc, char const* argv[])
             }
             else
             {
-                std::cout << "Could not generate image for " << argv[i] << std::endl;
+                std::cout << "Could not generate image for " << input_file << std::endl;
             }
         }
     }
@@ -111,5 +158,14 @@ int main(int argc, char const* argv[])
         std::cerr << "Error: insufficient memory" << std::endl;
         retVal = 100;
     }
+    if(dry_run)
+    {
+        std::cout << (first_estimate ? "]" : "]\n") << std::endl;
+    }
+    if(!Trace::close())
+    {
+        std::cerr << "Failed to write trace to file" << std::endl;
+        retVal = 1;
+    }
     return retVal;
 }
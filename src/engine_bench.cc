@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <malloc.h>
+#include <unistd.h>
+#include "easy_image.h"
+#include "ini_configuration.h"
+#include "Control.h"
+#include "LSystemCache.h"
+#include "MeshCache.h"
+#include "Stats.h"
+
+// #### - USAGE - ####
+// engine_bench [--repeat n] [--out results.json] [--scenes dir] [--filter x] [extra.ini ...]
+//
+// Renders every scene n times (default 5) after one warm-up run and reports median/p95 wall time, peak RSS and
+// throughput as JSON. Scene paths are relative to the ini_files directory, extra scenes are taken as given.
+// #### - USAGE - ####
+
+namespace {
+
+    /**
+     * @brief Scene rendered by the benchmark
+     */
+    struct Scene {
+        std::string name;
+        std::string path;
+    };
+
+    /**
+     * @brief Curated scenes, the bench/ ones are synthetic stress scenes
+     */
+    const std::vector<Scene> curated_scenes = {
+            {"lsystem2d_stochastic_027", "stochastic_l_systems/l_systems027.ini"},
+            {"lsystem2d_stochastic_029", "stochastic_l_systems/l_systems029.ini"},
+            {"lsystem2d_tree", "bench/bench_lsystem2d.ini"},
+            {"lsystem3d_plant", "bench/bench_lsystem3d.ini"},
+            {"sphere_textured", "textures/textures002.ini"},
+            {"sphere_shadowed", "textures/textures026.ini"},
+            {"sphere_shadowed_lights", "textures/textures028.ini"},
+            {"fractals", "bench/bench_fractal.ini"},
+            {"menger_sponge", "bench/bench_menger.ini"},
+            {"wireframe_large", "bench/bench_wireframe.ini"},
+            {"spheres_shadowed_stress", "bench/bench_spheres.ini"}
+    };
+
+    /**
+     * @brief Results of all runs of a scene
+     */
+    struct Result {
+        Scene scene;
+        std::vector<double> times;
+        long peak_rss_kb = 0;
+        Stats::Counters counters;
+        std::string error;
+    };
+
+    /**
+     * @brief Reset the peak RSS of the process, only supported on Linux
+     *
+     * @return true if the peak was reset
+     */
+    bool reset_peak_rss() {
+#ifdef __GLIBC__
+        // Return memory freed by previous scenes to the OS, otherwise it stays resident
+        malloc_trim(0);
+#endif
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        if (!clear_refs) return false;
+        clear_refs << "5";
+        return static_cast<bool>(clear_refs);
+    }
+
+    /**
+     * @brief Get the peak RSS of the process in kB
+     */
+    long peak_rss_kb() {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::stol(line.substr(6));
+            }
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    /**
+     * @brief Get value at percentile p of a sorted vector, nearest-rank method
+     */
+    double percentile(const std::vector<double> &sorted, const double p) {
+        if (sorted.empty()) return 0;
+        std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100.0 * sorted.size()));
+        if (rank == 0) rank = 1;
+        return sorted[std::min(rank, sorted.size()) - 1];
+    }
+
+    double per_second(const uint64_t count, const double seconds) {
+        return seconds > 0 ? static_cast<double>(count) / seconds : 0;
+    }
+
+    /**
+     * @brief Render the scene once, image is encoded in memory so the disk is not measured
+     *
+     * Meshes and L-systems cached by earlier runs are dropped first, otherwise every run after the warm-up only
+     * measures cache hits.
+     *
+     * @return Wall time in seconds
+     */
+    double render(const ini::Configuration &configuration) {
+        MeshCache::clear();
+        LSystemCache::clear();
+        Stats::reset();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        img::EasyImage image = Control::generate_image(configuration);
+        std::ostringstream out;
+        out << image;
+        Stats::counters().bytes_written += out.str().size();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    Result run_scene(const Scene &scene, const int repeat) {
+
+        Result result;
+        result.scene = scene;
+
+        // Scenes refer to textures and L-system files relative to their own directory
+        std::string directory = ".";
+        std::string file_name = scene.path;
+        std::string::size_type pos = scene.path.rfind('/');
+        if (pos != std::string::npos) {
+            directory = scene.path.substr(0, pos);
+            file_name = scene.path.substr(pos + 1);
+        }
+
+        char cwd[4096];
+        if (getcwd(cwd, sizeof(cwd)) == nullptr || chdir(directory.c_str()) != 0) {
+            result.error = "could not enter directory " + directory;
+            return result;
+        }
+
+        try {
+            ini::Configuration configuration;
+            std::ifstream fin(file_name);
+            if (!fin) throw std::runtime_error("could not open " + scene.path);
+            fin >> configuration;
+            fin.close();
+
+            bool reset = reset_peak_rss();
+            // Warm-up run, fills page tables
+            render(configuration);
+            for (int i = 0; i != repeat; i++) {
+                result.times.emplace_back(render(configuration));
+            }
+            result.counters = Stats::counters();
+            result.peak_rss_kb = reset ? peak_rss_kb() : -1;
+        }
+        catch (const std::bad_alloc &exception) {
+            result.error = "insufficient memory";
+        }
+        catch (const std::exception &exception) {
+            result.error = exception.what();
+        }
+
+        if (chdir(cwd) != 0) {
+            result.error = "could not return to working directory";
+        }
+        return result;
+    }
+
+    void write_json(std::ostream &out, const std::vector<Result> &results, const int repeat) {
+
+        out << "{\n";
+        out << "  \"benchmark\": \"engine_bench\",\n";
+        out << "  \"repeat\": " << repeat << ",\n";
+        out << "  \"scenes\": [";
+        for (std::size_t i = 0; i != results.size(); i++) {
+            const Result &result = results[i];
+            out << (i != 0 ? ",\n" : "\n") << "    {\n";
+            out << "      \"name\": \"" << result.scene.name << "\",\n";
+            out << "      \"path\": \"" << result.scene.path << "\",\n";
+            if (!result.error.empty()) {
+                out << "      \"error\": \"" << result.error << "\"\n    }";
+                continue;
+            }
+            std::vector<double> sorted = result.times;
+            std::sort(sorted.begin(), sorted.end());
+            double median = percentile(sorted, 50);
+            const Stats::Counters &c = result.counters;
+
+            out << "      \"runs\": " << sorted.size() << ",\n";
+            out << "      \"min_ms\": " << sorted.front() * 1000.0 << ",\n";
+            out << "      \"median_ms\": " << median * 1000.0 << ",\n";
+            out << "      \"p95_ms\": " << percentile(sorted, 95) * 1000.0 << ",\n";
+            out << "      \"peak_rss_kb\": " << result.peak_rss_kb << ",\n";
+            out << "      \"triangles\": " << c.triangles_submitted << ",\n";
+            out << "      \"shaded_pixels\": " << c.pixels_passed << ",\n";
+            out << "      \"lsystem_symbols\": " << c.lsystem_symbols << ",\n";
+            out << "      \"triangles_per_s\": " << per_second(c.triangles_submitted, median) << ",\n";
+            out << "      \"shaded_pixels_per_s\": " << per_second(c.pixels_passed, median) << ",\n";
+            out << "      \"lsystem_symbols_per_s\": " << per_second(c.lsystem_symbols, median) << "\n";
+            out << "    }";
+        }
+        out << "\n  ]\n";
+        out << "}\n";
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    int repeat = 5;
+    std::string out_file;
+    std::string scene_dir = ENGINE_SCENE_DIR;
+    std::string filter;
+    std::vector<Scene> extra_scenes;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--repeat" && i + 1 < argc)
+        {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            out_file = argv[++i];
+        }
+        else if (arg == "--scenes" && i + 1 < argc)
+        {
+            scene_dir = argv[++i];
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            extra_scenes.push_back(Scene{arg, arg});
+        }
+    }
+
+    std::vector<Scene> scenes;
+    for (const Scene &i : curated_scenes)
+    {
+        if (filter.empty() || i.name.find(filter) != std::string::npos)
+        {
+            scenes.push_back(Scene{i.name, scene_dir + "/" + i.path});
+        }
+    }
+    scenes.insert(scenes.end(), extra_scenes.begin(), extra_scenes.end());
+
+    Stats::set_enabled(true);
+    std::vector<Result> results;
+    int retVal = 0;
+    for (const Scene &i : scenes)
+    {
+        std::cerr << i.name << std::endl;
+        results.emplace_back(run_scene(i, repeat));
+        if (!results.back().error.empty())
+        {
+            std::cerr << "Error in scene " << i.name << ": " << results.back().error << std::endl;
+            retVal = 1;
+        }
+    }
+
+    if (out_file.empty())
+    {
+        write_json(std::cout, results, repeat);
+    }
+    else
+    {
+        std::ofstream out(out_file, std::ios::trunc | std::ios::out);
+        write_json(out, results, repeat);
+    }
+    return retVal;
+}
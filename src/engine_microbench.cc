@@ -0,0 +1,683 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <vector>
+#include "Control.h"
+#include "easy_image.h"
+#include "vector3d.h"
+#include "Figure.h"
+#include "Platonic.h"
+#include "Transform.h"
+#include "LSystem2D.h"
+#include "LSystem3D.h"
+#include "LSystemIterator.h"
+#include "Light.h"
+#include "Parallel.h"
+#include "ZBuffer.h"
+#include "Utils.h"
+#include "l_parser.h"
+
+// #### - USAGE - ####
+// engine_microbench [--json] [--min-time seconds] [--filter x]
+//
+// Times the hot kernels of the engine on fixed random inputs and reports ns/op and items/s. Every kernel can have
+// several variants, these are listed together and compared against the first variant of the kernel.
+// #### - USAGE - ####
+
+namespace {
+
+    /**
+     * @brief Seed for all generated inputs, keeps runs comparable
+     */
+    const unsigned int SEED = 20210505;
+
+    /**
+     * @brief Side of the image used by the raster kernels
+     */
+    const unsigned int SIZE = 1024;
+
+    /**
+     * @brief Kernel that can be benchmarked
+     *
+     * run(n) performs n operations and returns the amount of items processed by them.
+     */
+    struct Kernel {
+        std::string name;
+        std::string variant;
+        std::function<uint64_t(uint64_t)> run;
+        /**
+         * @brief Extra information about the input, printed next to the measurement
+         */
+        std::string info;
+    };
+
+    /**
+     * @brief Measurement of a kernel
+     */
+    struct Result {
+        std::string name;
+        std::string variant;
+        double ns_per_op;
+        double items_per_s;
+        std::string info;
+    };
+
+    /**
+     * @brief Keeps the compiler from optimising kernels away
+     */
+    volatile double sink = 0;
+
+    std::vector<Kernel> &kernels() {
+        static std::vector<Kernel> x;
+        return x;
+    }
+
+    void add_kernel(const std::string &name, const std::string &variant, const std::function<uint64_t(uint64_t)> &run,
+                    const std::string &info = "") {
+        kernels().push_back(Kernel{name, variant, run, info});
+    }
+
+    /**
+     * @brief Time a kernel, the amount of operations is doubled until a sample takes min_time
+     *
+     * @return Median of 5 samples
+     */
+    Result measure(const Kernel &kernel, const double min_time) {
+
+        uint64_t ops = 1;
+        double seconds = 0;
+        uint64_t items = 0;
+        while (true) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            items = kernel.run(ops);
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (seconds >= min_time || ops >= (uint64_t(1) << 40)) break;
+            ops *= 2;
+        }
+
+        std::vector<std::pair<double, uint64_t>> samples;
+        for (int i = 0; i != 5; i++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            items = kernel.run(ops);
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            samples.emplace_back(seconds, items);
+        }
+        std::sort(samples.begin(), samples.end());
+        const std::pair<double, uint64_t> &median = samples[samples.size() / 2];
+
+        return Result{kernel.name, kernel.variant, median.first * 1e9 / static_cast<double>(ops),
+                      static_cast<double>(median.second) / median.first, kernel.info};
+    }
+
+    /**
+     * @brief Random triangles in eye-coordinates that project to roughly "side" pixels wide on a SIZE image
+     */
+    std::vector<Vector3D> random_triangles(const unsigned int count, const double side, const double d,
+                                           const double dx, const double dy) {
+
+        std::mt19937 generator(SEED);
+        std::uniform_real_distribution<double> screen(side, SIZE - side - 1);
+        std::uniform_real_distribution<double> offset(-side / 2, side / 2);
+        std::uniform_real_distribution<double> depth(-20, -5);
+
+        std::vector<Vector3D> points;
+        for (unsigned int i = 0; i != count; i++) {
+            double cx = screen(generator);
+            double cy = screen(generator);
+            for (int j = 0; j != 3; j++) {
+                double z = depth(generator);
+                double x = cx + offset(generator);
+                double y = cy + offset(generator);
+                // Invert projection x' = d * x / -z + dx
+                points.emplace_back(Vector3D::point((x - dx) * -z / d, (y - dy) * -z / d, z));
+            }
+        }
+        return points;
+    }
+
+    void add_triag_kernel(const std::string &size_name, const double side) {
+
+        const double d = 1000;
+        const double dx = SIZE / 2.0;
+        const double dy = SIZE / 2.0;
+        std::shared_ptr<std::vector<Vector3D>> points =
+                std::make_shared<std::vector<Vector3D>>(random_triangles(4096, side, d, dx, dy));
+        std::shared_ptr<img::EasyImage> image = std::make_shared<img::EasyImage>(SIZE, SIZE);
+        std::shared_ptr<ZBuffer> buffer = std::make_shared<ZBuffer>(SIZE, SIZE);
+        std::shared_ptr<Lights3D> lights = std::make_shared<Lights3D>();
+        std::shared_ptr<img::EasyImage> texture = std::make_shared<img::EasyImage>();
+
+        add_kernel("draw_zbuf_triag/" + size_name, "baseline", [=](uint64_t n) {
+            const Matrix eye;
+            const cc::Color ambient(0.5, 0.5, 0.5);
+            const cc::Color black;
+            const unsigned int count = points->size() / 3;
+            for (uint64_t i = 0; i != n; i++) {
+                unsigned int t = i % count;
+                // Start over with an empty buffer, otherwise every pixel fails the depth-test
+                if (t == 0) *buffer = ZBuffer(SIZE, SIZE);
+                image->draw_zbuf_triag(*buffer, (*points)[3 * t], (*points)[3 * t + 1], (*points)[3 * t + 2],
+                                       d, dx, dy, ambient, black, black, 0, *lights, eye, false, *texture, false,
+                                       Vector3D::point(0, 0, 0));
+            }
+            return n;
+        });
+    }
+
+    void add_line_kernels() {
+
+        std::mt19937 generator(SEED);
+        std::uniform_int_distribution<unsigned int> coordinate(0, SIZE - 1);
+        std::uniform_real_distribution<double> depth(-20, -5);
+
+        std::shared_ptr<std::vector<unsigned int>> coordinates = std::make_shared<std::vector<unsigned int>>();
+        std::shared_ptr<std::vector<double>> depths = std::make_shared<std::vector<double>>();
+        for (unsigned int i = 0; i != 4096 * 4; i++) {
+            coordinates->push_back(coordinate(generator));
+        }
+        for (unsigned int i = 0; i != 4096 * 2; i++) {
+            depths->push_back(depth(generator));
+        }
+        std::shared_ptr<img::EasyImage> image = std::make_shared<img::EasyImage>(SIZE, SIZE);
+        std::shared_ptr<ZBuffer> buffer = std::make_shared<ZBuffer>(SIZE, SIZE);
+
+        add_kernel("draw_line", "baseline", [=](uint64_t n) {
+            const img::Color color(255, 255, 255);
+            for (uint64_t i = 0; i != n; i++) {
+                const unsigned int *c = &(*coordinates)[4 * (i % 4096)];
+                image->draw_line(c[0], c[1], c[2], c[3], color);
+            }
+            return n;
+        });
+
+        add_kernel("draw_zbuf_line", "baseline", [=](uint64_t n) {
+            const img::Color color(255, 255, 255);
+            for (uint64_t i = 0; i != n; i++) {
+                unsigned int l = i % 4096;
+                if (l == 0) *buffer = ZBuffer(SIZE, SIZE);
+                const unsigned int *c = &(*coordinates)[4 * l];
+                image->draw_zbuf_line(*buffer, c[0], c[1], (*depths)[2 * l], c[2], c[3], (*depths)[2 * l + 1], color);
+            }
+            return n;
+        });
+    }
+
+    Matrix random_matrix(std::mt19937 &generator) {
+
+        std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+        std::uniform_real_distribution<double> value(-5, 5);
+        return Figure::rotateX(angle(generator)) * Figure::rotateY(angle(generator))
+               * Figure::scale_figure(std::fabs(value(generator)) + 0.5)
+               * Figure::translate(Vector3D::point(value(generator), value(generator), value(generator)));
+    }
+
+    void add_transform_kernels(const unsigned int nr_points) {
+
+        std::mt19937 generator(SEED);
+        std::uniform_real_distribution<double> value(-10, 10);
+        std::shared_ptr<std::vector<Vector3D>> vectors = std::make_shared<std::vector<Vector3D>>();
+        std::shared_ptr<Figure> figure = std::make_shared<Figure>();
+        for (unsigned int i = 0; i != nr_points; i++) {
+            vectors->emplace_back(Vector3D::point(value(generator), value(generator), value(generator)));
+            figure->get_points().emplace_back(vectors->back());
+        }
+        // Rotation only, points stay in range no matter how often it is applied
+        Matrix rotation = Figure::rotateX(0.001) * Figure::rotateZ(0.002);
+        const std::string size = std::to_string(nr_points);
+
+        // One Vector3D at a time, as Figure did before the points were stored as separate arrays
+        add_kernel("apply_transformation/" + size, "aos", [=](uint64_t n) {
+            for (uint64_t i = 0; i != n; i++) {
+                for (Vector3D &j : *vectors) {
+                    j *= rotation;
+                }
+            }
+            return n * nr_points;
+        });
+
+        add_kernel("apply_transformation/" + size, std::string("soa_") + Transform::instruction_set(),
+                   [=](uint64_t n) {
+            for (uint64_t i = 0; i != n; i++) {
+                figure->apply_transformation(rotation);
+            }
+            return n * nr_points;
+        });
+
+        add_kernel("transform_project/" + size, "aos", [=](uint64_t n) {
+            std::vector<Point2D> projected;
+            for (uint64_t i = 0; i != n; i++) {
+                projected.clear();
+                for (Vector3D &j : *vectors) {
+                    j *= rotation;
+                    projected.emplace_back(Figure::do_projection(j, 1));
+                }
+            }
+            sink = sink + projected.back().getX();
+            return n * nr_points;
+        });
+
+        std::shared_ptr<std::vector<double>> projected_x = std::make_shared<std::vector<double>>();
+        std::shared_ptr<std::vector<double>> projected_y = std::make_shared<std::vector<double>>();
+        add_kernel("transform_project/" + size, std::string("soa_") + Transform::instruction_set(),
+                   [=](uint64_t n) {
+            for (uint64_t i = 0; i != n; i++) {
+                figure->get_points().transform_project(rotation, 1, *projected_x, *projected_y);
+            }
+            sink = sink + projected_x->back();
+            return n * nr_points;
+        });
+    }
+
+    void add_matrix_kernels() {
+
+        std::mt19937 generator(SEED);
+        std::shared_ptr<std::vector<Matrix>> matrices = std::make_shared<std::vector<Matrix>>();
+        for (int i = 0; i != 64; i++) {
+            matrices->push_back(random_matrix(generator));
+        }
+
+        add_kernel("matrix_multiply", "baseline", [=](uint64_t n) {
+            Matrix x;
+            for (uint64_t i = 0; i != n; i++) {
+                x = (*matrices)[i % 64] * (*matrices)[(i + 1) % 64];
+            }
+            sink = sink + x(1, 1);
+            return n;
+        });
+
+        add_kernel("matrix_inverse", "baseline", [=](uint64_t n) {
+            Matrix x;
+            for (uint64_t i = 0; i != n; i++) {
+                x = Matrix::inv((*matrices)[i % 64]);
+            }
+            sink = sink + x(1, 1);
+            return n;
+        });
+    }
+
+    /**
+     * @brief Expansion one iteration at a time as LSystem_2D::generate_string did before LSystemExpansion
+     */
+    std::string recursive_generate_string(const LParser::LSystem &l_system, int iter, std::string &l_system_string) {
+
+        if (iter == 0) return l_system_string;
+
+        std::string x;
+        for (const char & i : l_system_string) {
+            if (i == '+' || i == '-' || i == '[' || i == ']' || i == '(' || i == ')') {
+                x += i;
+                continue;
+            }
+            x += l_system.get_replacement(i);
+        }
+        return recursive_generate_string(l_system, iter - 1, x);
+    }
+
+    /**
+     * @brief Turtle of LSystem_3D::drawLSystem before the rotations were precomputed, rotates with Vector3D and keeps
+     * its state on a std::stack
+     */
+    Figure vector_drawLSystem_3D(const LParser::LSystem3D &l_system_3D) {
+
+        LSystemIterator symbols(l_system_3D, l_system_3D.get_nr_iterations());
+        Figure l_system;
+        const double a = l_system_3D.get_angle() * M_PI / 180;
+        Vector3D position = Vector3D::point(0, 0, 0);
+        Vector3D H = Vector3D::vector(1, 0, 0);
+        Vector3D L = Vector3D::vector(0, 1, 0);
+        Vector3D U = Vector3D::vector(0, 0, 1);
+        std::stack<std::vector<Vector3D>> stack;
+
+        // Rotate x and y over angle b, as x' = x cos(b) + y sin(b) and y' = -x sin(b) + y cos(b)
+        auto rotate = [](Vector3D &x, Vector3D &y, const double b) {
+            Vector3D x_ = x * cos(b) + y * sin(b);
+            Vector3D y_ = -x * sin(b) + y * cos(b);
+            x = x_;
+            y = y_;
+        };
+        char i;
+        while (symbols.next(i)) {
+            const LParser::LSystem::Symbol &symbol = l_system_3D.get_symbol(i);
+            switch (symbol.type) {
+                case LParser::LSystem::TURN:
+                    if (i == '+') rotate(H, L, a);
+                    else if (i == '-') rotate(H, L, -a);
+                    else if (i == '^') rotate(H, U, a);
+                    else if (i == '&') rotate(H, U, -a);
+                    else if (i == '\\') rotate(U, L, a);
+                    else if (i == '/') rotate(U, L, -a);
+                    else if (i == '|') {
+                        H = -H;
+                        L = -L;
+                    }
+                    break;
+                case LParser::LSystem::PUSH:
+                    stack.push({position, H, L, U});
+                    break;
+                case LParser::LSystem::POP:
+                    position = stack.top()[0];
+                    H = stack.top()[1];
+                    L = stack.top()[2];
+                    U = stack.top()[3];
+                    stack.pop();
+                    break;
+                case LParser::LSystem::DRAW:
+                case LParser::LSystem::MOVE: {
+                    Vector3D old_position = position;
+                    position = position + H;
+                    if (symbol.type == LParser::LSystem::DRAW) {
+                        l_system.get_points().emplace_back(old_position);
+                        l_system.get_points().emplace_back(position);
+                        l_system.add_face({int(l_system.get_points().size() - 1),
+                                           int(l_system.get_points().size() - 2)});
+                    }
+                    break;
+                }
+                case LParser::LSystem::IGNORED:
+                    break;
+            }
+        }
+        return l_system;
+    }
+
+    void add_lsystem_kernels() {
+
+        std::istringstream input("Alphabet = {F, X}\n"
+                                 "Draw = {F -> 1, X -> 0}\n"
+                                 "Rules = {F -> \"FF\", X -> \"F(+X)F(-X)+X\"}\n"
+                                 "Initiator = \"X\"\n"
+                                 "Angle = 20\n"
+                                 "StartingAngle = 90\n"
+                                 "Iterations = 8\n");
+        std::shared_ptr<LParser::LSystem2D> l_system = std::make_shared<LParser::LSystem2D>(input);
+
+        add_kernel("generate_string/8", "baseline", [=](uint64_t n) {
+            uint64_t items = 0;
+            for (uint64_t i = 0; i != n; i++) {
+                std::string initiator = l_system->get_initiator();
+                items += recursive_generate_string(*l_system, l_system->get_nr_iterations(), initiator).size();
+            }
+            return items;
+        });
+
+        // 0 threads uses every core
+        for (unsigned int threads : {1u, 0u}) {
+            add_kernel("generate_string/8",
+                       threads == 1 ? "serial" : "parallel_" + std::to_string(Parallel::nr_threads()),
+                       [=](uint64_t n) {
+                Parallel::set_nr_threads(threads);
+                uint64_t items = 0;
+                for (uint64_t i = 0; i != n; i++) {
+                    std::string initiator = l_system->get_initiator();
+                    items += LSystem_2D::generate_string(*l_system, l_system->get_nr_iterations(), initiator).size();
+                }
+                Parallel::set_nr_threads(0);
+                return items;
+            });
+        }
+
+        // Same lines up to rounding, the memoized turtle draws every symbol once per amount of iterations left
+        add_kernel("draw_lsystem/2d/8", "walk", [=](uint64_t n) {
+            uint64_t items = 0;
+            for (uint64_t i = 0; i != n; i++) {
+                items += LSystem_2D::drawLSystem_walk(*l_system, cc::Color(1, 1, 1)).size();
+            }
+            return items;
+        });
+        add_kernel("draw_lsystem/2d/8", "memoized", [=](uint64_t n) {
+            uint64_t items = 0;
+            for (uint64_t i = 0; i != n; i++) {
+                items += LSystem_2D::drawLSystem_memoized(*l_system, cc::Color(1, 1, 1)).size();
+            }
+            return items;
+        });
+
+        // Bushy plant that turns around every axis, about 266k symbols and 59k lines
+        std::istringstream plant_input("Alphabet = {A, F}\n"
+                                       "Draw = {A -> 1, F -> 1}\n"
+                                       "Rules = {A -> \"F(&FA)/////(&FA)///////(&FA)\", F -> \"F\"}\n"
+                                       "Initiator = \"A\"\n"
+                                       "Angle = 22.5\n"
+                                       "Iterations = 9\n");
+        std::shared_ptr<LParser::LSystem3D> plant = std::make_shared<LParser::LSystem3D>(plant_input);
+
+        add_kernel("draw_lsystem/3d/plant", "baseline", [=](uint64_t n) {
+            uint64_t items = 0;
+            for (uint64_t i = 0; i != n; i++) {
+                items += vector_drawLSystem_3D(*plant).nr_faces();
+            }
+            return items;
+        });
+        add_kernel("draw_lsystem/3d/plant", "rotation_table", [=](uint64_t n) {
+            uint64_t items = 0;
+            for (uint64_t i = 0; i != n; i++) {
+                items += LSystem_3D::drawLSystem(*plant).nr_faces();
+            }
+            return items;
+        });
+
+        std::istringstream stochastic_input("Alphabet = {A}\n"
+                                            "Draw = {A -> 1}\n"
+                                            "Rules = {A[0.5] -> \"A(+A)(-A)A\", A[0.3] -> \"A(-A)A\", "
+                                            "A[0.2] -> \"A(+A)A\"}\n"
+                                            "Initiator = \"A\"\n"
+                                            "Angle = 22.5\n"
+                                            "StartingAngle = 0\n"
+                                            "Iterations = 9\n");
+        std::shared_ptr<LParser::LSystem2D> stochastic = std::make_shared<LParser::LSystem2D>(stochastic_input);
+        stochastic->set_seed(SEED);
+
+        add_kernel("generate_string/stochastic/9", "alias", [=](uint64_t n) {
+            uint64_t items = 0;
+            for (uint64_t i = 0; i != n; i++) {
+                std::string initiator = stochastic->get_initiator();
+                items += LSystem_2D::generate_string(*stochastic, stochastic->get_nr_iterations(), initiator).size();
+            }
+            return items;
+        });
+    }
+
+    void add_shadow_kernels() {
+
+        const int mask_size = 1024;
+        Vector3D eye_point = Vector3D::point(100, 50, 75);
+        Vector3D light_point = Vector3D::point(20, 30, 40);
+        Matrix eye = Figure::eye_point_trans(eye_point);
+
+        std::shared_ptr<PointLight> light = std::make_shared<PointLight>(
+                std::vector<double>{0, 0, 0}, std::vector<double>{1, 1, 1}, std::vector<double>{0, 0, 0},
+                light_point * eye, 0);
+        light->setShadowMask(mask_size, mask_size);
+        light->setEye(Figure::eye_point_trans(light_point));
+        light->setInvEye(Matrix::inv(eye));
+
+        Figures3D figures;
+        figures.push_back(Platonic::sphere(4));
+        Utils::triangulate_figures(figures);
+        light->createShadowMask(figures, mask_size);
+
+        // Random points just inside the sphere so every lookup stays on the mask, in eye-coordinates
+        std::mt19937 generator(SEED);
+        std::normal_distribution<double> normal(0, 1);
+        std::shared_ptr<std::vector<Vector3D>> points = std::make_shared<std::vector<Vector3D>>();
+        for (int i = 0; i != 4096; i++) {
+            Vector3D p = Vector3D::point(normal(generator), normal(generator), normal(generator));
+            p.normalise();
+            points->push_back((p * 0.9) * eye);
+        }
+
+        add_kernel("checkShadowMask", "baseline", [=](uint64_t n) {
+            uint64_t shadowed = 0;
+            for (uint64_t i = 0; i != n; i++) {
+                shadowed += light->checkShadowMask((*points)[i % 4096]);
+            }
+            sink = sink + shadowed;
+            return n;
+        });
+    }
+
+    /**
+     * @brief MengerSponge with its last "merged" iterations merged into one mesh, as done by Control::generate_figures
+     */
+    Figures3D menger_sponge(const int iterations, const int merged) {
+
+        Figure sponge = Platonic::cube();
+        Utils::fractal(sponge, iterations - merged, 3, true);
+        if (merged != 0) Utils::merge_menger_sponge(sponge, merged);
+        sponge.setAmbientReflection({0.5, 0.5, 0.5});
+        sponge.setTextureFlag(false);
+
+        Figures3D figures = {sponge};
+        Utils::triangulate_figures(figures);
+        return figures;
+    }
+
+    void add_menger_kernels(const int iterations) {
+
+        const std::string name = "menger_sponge/" + std::to_string(iterations);
+        uint64_t instanced_triangles = 0;
+
+        for (int merged : {0, std::min(iterations, Utils::MENGER_MERGED_LEVELS)}) {
+            std::shared_ptr<Figures3D> figures = std::make_shared<Figures3D>(menger_sponge(iterations, merged));
+
+            // Triangles handed to the rasterizer per render
+            uint64_t triangles = 0;
+            for (const Figure &i : *figures) triangles += i.nr_instances() * i.get_triangles().size();
+            if (merged == 0) instanced_triangles = triangles;
+
+            char info[64];
+            std::snprintf(info, sizeof(info), "triangles %llu (%+.1f%%)", static_cast<unsigned long long>(triangles),
+                          100.0 * (static_cast<double>(triangles) / instanced_triangles - 1));
+
+            add_kernel(name, merged == 0 ? "instanced" : "merged", [=](uint64_t n) {
+                Matrix eye = Figure::eye_point_trans(Vector3D::point(100, 50, 75));
+                ini::Configuration configuration;
+                Lights3D lights;
+                double image_x, image_y, d, dx, dy;
+                for (uint64_t i = 0; i != n; i++) {
+                    img::EasyImage image(512, 512);
+                    ZBuffer buffer(0, 0);
+                    Control::draw_triangles(*figures, eye, 512, false, configuration, lights, image_x, image_y,
+                                            d, dx, dy, buffer, image);
+                }
+                return n * triangles;
+            }, info);
+        }
+    }
+
+    void add_fractal_kernels(const std::string &name, const Figure &figure, const int iterations, const double scale,
+                             const bool menger_sponge) {
+
+        // 0 threads uses every core
+        for (unsigned int threads : {1u, 0u}) {
+            add_kernel("fractal/" + name + "/" + std::to_string(iterations),
+                       threads == 1 ? "serial" : "parallel_" + std::to_string(Parallel::nr_threads()),
+                       [=](uint64_t n) {
+                Parallel::set_nr_threads(threads);
+                uint64_t items = 0;
+                for (uint64_t i = 0; i != n; i++) {
+                    Figure x = figure;
+                    Utils::fractal(x, iterations, scale, menger_sponge);
+                    items += x.get_instances().size();
+                }
+                Parallel::set_nr_threads(0);
+                return items;
+            });
+        }
+    }
+
+    void register_kernels() {
+        add_triag_kernel("small", 4);
+        add_triag_kernel("medium", 64);
+        add_triag_kernel("large", 256);
+        add_line_kernels();
+        add_transform_kernels(1000);
+        add_transform_kernels(1000000);
+        add_matrix_kernels();
+        add_lsystem_kernels();
+        add_shadow_kernels();
+        for (int i = 1; i <= 4; i++) add_menger_kernels(i);
+        add_fractal_kernels("tetrahedron", Platonic::tetrahedron(), 9, 2, false);
+        add_fractal_kernels("menger_sponge", Platonic::cube(), 5, 3, true);
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    bool json = false;
+    double min_time = 0.1;
+    std::string filter;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--json")
+        {
+            json = true;
+        }
+        else if (arg == "--min-time" && i + 1 < argc)
+        {
+            min_time = std::atof(argv[++i]);
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    register_kernels();
+
+    std::vector<Result> results;
+    for (const Kernel &i : kernels())
+    {
+        if (!filter.empty() && i.name.find(filter) == std::string::npos) continue;
+        results.push_back(measure(i, min_time));
+
+        // Compare against the first variant of the same kernel
+        double baseline = results.back().ns_per_op;
+        for (const Result &j : results)
+        {
+            if (j.name == i.name)
+            {
+                baseline = j.ns_per_op;
+                break;
+            }
+        }
+        const Result &result = results.back();
+        if (!json)
+        {
+            std::printf("%-32s %-12s %14.1f ns/op %14.4g items/s %8.2fx  %s\n", result.name.c_str(),
+                        result.variant.c_str(), result.ns_per_op, result.items_per_s, baseline / result.ns_per_op,
+                        result.info.c_str());
+        }
+    }
+
+    if (json)
+    {
+        std::cout << "{\n  \"benchmark\": \"engine_microbench\",\n  \"kernels\": [";
+        for (std::size_t i = 0; i != results.size(); i++)
+        {
+            std::cout << (i != 0 ? ",\n" : "\n") << "    {\"name\": \"" << results[i].name << "\", \"variant\": \""
+                      << results[i].variant << "\", \"ns_per_op\": " << results[i].ns_per_op
+                      << ", \"items_per_s\": " << results[i].items_per_s;
+            if (!results[i].info.empty()) std::cout << ", \"info\": \"" << results[i].info << "\"";
+            std::cout << "}";
+        }
+        std::cout << "\n  ]\n}\n";
+    }
+    return 0;
+}
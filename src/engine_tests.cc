@@ -0,0 +1,378 @@
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Control.h"
+#include "easy_image.h"
+#include "Estimate.h"
+#include "ini_configuration.h"
+#include "l_parser.h"
+#include "LSystem2D.h"
+#include "LSystemCache.h"
+#include "LSystemExpansion.h"
+#include "LSystemIterator.h"
+#include "MeshCache.h"
+#include "Parallel.h"
+#include "Stats.h"
+#include "Utils.h"
+
+// #### - USAGE - ####
+// engine_tests [--filter x]
+//
+// Renders small scenes in memory and checks the counters and geometry they produce. Prints every failed check and
+// returns 1 if any test failed.
+// #### - USAGE - ####
+
+namespace {
+
+    /**
+     * @brief Test that can be run, check records failures through the CHECK macro
+     */
+    struct Test {
+        std::string name;
+        std::function<void()> run;
+    };
+
+    std::vector<Test> &tests() {
+        static std::vector<Test> x;
+        return x;
+    }
+
+    int failures = 0;
+
+    void add_test(const std::string &name, const std::function<void()> &run) {
+        tests().push_back(Test{name, run});
+    }
+
+    void check(const bool passed, const char *expression, const char *file, const int line) {
+        if (passed) return;
+        failures++;
+        std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+    }
+
+#define CHECK(x) check((x), #x, __FILE__, __LINE__)
+
+    /**
+     * @brief Parse .ini data given as a string
+     */
+    void parse(const std::string &ini, ini::Configuration &configuration) {
+        std::istringstream input_stream(ini);
+        input_stream >> configuration;
+    }
+
+    /**
+     * @brief Render the scene and return the counters of the render
+     */
+    Stats::Counters render(const ini::Configuration &configuration) {
+        Stats::reset();
+        Control::generate_image(configuration);
+        return Stats::counters();
+    }
+
+    void register_lighting_tests() {
+
+        // Point light, infinite light and specular highlights, every shaded pixel evaluates both lights once
+        add_test("lighting/lights_evaluated", []() {
+            ini::Configuration configuration;
+            parse(  "[General]\n"
+                    "size = 256\n"
+                    "backgroundcolor = (0, 0, 0)\n"
+                    "type = \"LightedZBuffering\"\n"
+                    "nrLights = 2\n"
+                    "eye = (100, 50, 75)\n"
+                    "nrFigures = 1\n"
+                    "[Light0]\n"
+                    "infinity = FALSE\n"
+                    "location = (5, 9, 10)\n"
+                    "ambientLight = (0.2, 0.2, 0.2)\n"
+                    "diffuseLight = (0.8, 0.8, 0.8)\n"
+                    "specularLight = (1, 1, 1)\n"
+                    "[Light1]\n"
+                    "infinity = TRUE\n"
+                    "direction = (-1, -2, -3)\n"
+                    "ambientLight = (0.2, 0.2, 0.2)\n"
+                    "diffuseLight = (0.5, 0.5, 0.5)\n"
+                    "[Figure0]\n"
+                    "type = \"Sphere\"\n"
+                    "scale = 2\n"
+                    "rotateX = 0\n"
+                    "rotateY = 0\n"
+                    "rotateZ = 0\n"
+                    "center = (0, 0, 0)\n"
+                    "n = 3\n"
+                    "ambientReflection = (0.5, 0.5, 0.5)\n"
+                    "diffuseReflection = (0.5, 0.5, 0.5)\n"
+                    "specularReflection = (0.7, 0.7, 0.7)\n"
+                    "reflectionCoefficient = 30\n", configuration);
+            const Stats::Counters counters = render(configuration);
+            CHECK(counters.pixels_passed != 0);
+            CHECK(counters.lights_evaluated == 2 * counters.pixels_passed);
+        });
+    }
+
+    void register_estimate_tests() {
+
+        // Copies of a sponge with merged levels are anchored on the 8 corners of the cube, not on the merged points
+        add_test("estimate/menger_sponge_triangles", []() {
+            ini::Configuration configuration;
+            parse(  "[General]\n"
+                    "size = 256\n"
+                    "backgroundcolor = (0, 0, 0)\n"
+                    "type = \"ZBuffering\"\n"
+                    "eye = (100, 50, 75)\n"
+                    "nrFigures = 1\n"
+                    "[Figure0]\n"
+                    "type = \"MengerSponge\"\n"
+                    "nrIterations = " + std::to_string(Utils::MENGER_MERGED_LEVELS + 1) + "\n"
+                    "rotateX = 0\n"
+                    "rotateY = 0\n"
+                    "rotateZ = 15\n"
+                    "scale = 1\n"
+                    "center = (0, 0, 0)\n"
+                    "color = (1, 1, 1)\n", configuration);
+            const Estimate::Scene scene = Estimate::estimate(configuration, false);
+            const Stats::Counters counters = render(configuration);
+            CHECK(scene.items.size() == 1);
+            CHECK(scene.items.front().instances == 20);
+            CHECK(scene.items.front().triangles == counters.triangles_submitted);
+        });
+
+        // Primitives with lod = "auto" are estimated with the tessellation the render chooses, not the finest one
+        add_test("estimate/auto_lod_triangles", []() {
+            ini::Configuration configuration;
+            parse(  "[General]\n"
+                    "size = 512\n"
+                    "backgroundcolor = (0, 0, 0)\n"
+                    "type = \"ZBuffering\"\n"
+                    "eye = (100, 50, 75)\n"
+                    "nrFigures = 4\n"
+                    "[Figure0]\n"
+                    "type = \"Sphere\"\n"
+                    "lod = \"auto\"\n"
+                    "scale = 3\n"
+                    "center = (0, 0, 0)\n"
+                    "color = (1, 0, 0)\n"
+                    "[Figure1]\n"
+                    "type = \"Torus\"\n"
+                    "lod = \"auto\"\n"
+                    "r = 0.5\n"
+                    "R = 2\n"
+                    "center = (0, -5, 0)\n"
+                    "color = (0, 0, 1)\n"
+                    "[Figure2]\n"
+                    "type = \"Cone\"\n"
+                    "lod = \"auto\"\n"
+                    "height = 3\n"
+                    "center = (4, 0, 0)\n"
+                    "color = (1, 1, 0)\n"
+                    "[Figure3]\n"
+                    "type = \"Cube\"\n"
+                    "scale = 2\n"
+                    "center = (0, 6, 0)\n"
+                    "color = (0, 1, 0)\n", configuration);
+            const Estimate::Scene scene = Estimate::estimate(configuration, false);
+            const Stats::Counters counters = render(configuration);
+            uint64_t triangles = 0;
+            for (const Estimate::Item &i : scene.items) triangles += i.triangles;
+            CHECK(Stats::lods().size() == 3);
+            CHECK(triangles == counters.triangles_submitted);
+        });
+    }
+
+    /**
+     * @brief Largest distance between the end points of two lists of lines, infinity if their amounts differ
+     */
+    double max_distance(Lines2D &a, Lines2D &b) {
+        if (a.size() != b.size()) return INFINITY;
+        double distance = 0;
+        Lines2D::iterator j = b.begin();
+        for (Line2D &i : a) {
+            distance = std::max(distance, std::abs(i.getP1().getX() - j->getP1().getX()));
+            distance = std::max(distance, std::abs(i.getP1().getY() - j->getP1().getY()));
+            distance = std::max(distance, std::abs(i.getP2().getX() - j->getP2().getX()));
+            distance = std::max(distance, std::abs(i.getP2().getY() - j->getP2().getY()));
+            ++j;
+        }
+        return distance;
+    }
+
+    void register_lsystem_tests() {
+
+        // Koch snowflake turns by 60 degrees, so rotated batches round differently from a turtle that walks every step
+        add_test("lsystem/2d_memoized_matches_walk", []() {
+            LParser::LSystem2D l_system;
+            std::istringstream input_stream("Alphabet = {F}\n"
+                                            "Draw = {F -> 1}\n"
+                                            "Rules = {F -> \"F-F++F-F\"}\n"
+                                            "Initiator = \"F++F++F\"\n"
+                                            "Angle = 60\n"
+                                            "StartingAngle = 0\n"
+                                            "Iterations = 6\n");
+            input_stream >> l_system;
+            CHECK(LSystem_2D::memoizable(l_system));
+
+            const cc::Color color(1, 1, 1);
+            Lines2D walked = LSystem_2D::drawLSystem_walk(l_system, color);
+            Lines2D drawn = LSystem_2D::drawLSystem(l_system, color);
+            Lines2D memoized = LSystem_2D::drawLSystem_memoized(l_system, color);
+            CHECK(walked.size() == 3 * 4096);
+            // Default lines are the walked ones exactly, memoized ones are the same lines up to rounding
+            CHECK(max_distance(drawn, walked) == 0);
+            CHECK(max_distance(memoized, walked) < 1e-9);
+        });
+
+        // Lines are copied into the cache when they are asked for a second time, taken from it the third time, and
+        // count the same symbols every time
+        add_test("lsystem/cache_hit_symbols", []() {
+            LParser::LSystem2D l_system;
+            std::istringstream input_stream("Alphabet = {F, X}\n"
+                                            "Draw = {F -> 1, X -> 0}\n"
+                                            "Rules = {F -> \"FF\", X -> \"F(+X)F(-X)+X\"}\n"
+                                            "Initiator = \"X\"\n"
+                                            "Angle = 20\n"
+                                            "StartingAngle = 90\n"
+                                            "Iterations = 5\n");
+            input_stream >> l_system;
+            MeshCache::clear();
+            LSystemCache::clear();
+            const cc::Color color(1, 1, 1);
+            Stats::Counters counters[3];
+            Lines2D lines[3];
+            for (int i = 0; i != 3; i++) {
+                Stats::reset();
+                lines[i] = LSystemCache::draw_2D(l_system, 1, color);
+                counters[i] = Stats::counters();
+                if (i == 0) CHECK(MeshCache::size() == 0);
+            }
+            CHECK(MeshCache::size() != 0);
+            MeshCache::clear();
+            LSystemCache::clear();
+            CHECK(counters[0].lsystem_cache_misses == 1);
+            CHECK(counters[1].lsystem_cache_misses == 1);
+            CHECK(counters[2].lsystem_cache_hits == 1);
+            CHECK(counters[0].lsystem_symbols != 0);
+            for (int i = 1; i != 3; i++) {
+                CHECK(counters[i].lsystem_symbols == counters[0].lsystem_symbols);
+                CHECK(max_distance(lines[i], lines[0]) == 0);
+            }
+        });
+
+        // Parallel expansion writes the same string as the depth-first iterator, however the parts are split over
+        // threads, and refuses strings longer than max_length before allocating them
+        add_test("lsystem/expand_matches_iterator", []() {
+            LParser::LSystem2D deterministic;
+            std::istringstream deterministic_input("Alphabet = {F, X}\n"
+                                                   "Draw = {F -> 1, X -> 0}\n"
+                                                   "Rules = {F -> \"FF\", X -> \"F(+X)F(-X)+X\"}\n"
+                                                   "Initiator = \"X\"\n"
+                                                   "Angle = 20\n"
+                                                   "StartingAngle = 90\n"
+                                                   "Iterations = 9\n");
+            deterministic_input >> deterministic;
+            LParser::LSystem2D stochastic;
+            std::istringstream stochastic_input("Alphabet = {A}\n"
+                                                "Draw = {A -> 1}\n"
+                                                "Rules = {A[0.50] -> \"A(+A)(-A)A\", A[0.30] -> \"A(-A)A\", "
+                                                "A[0.20] -> \"A(+A)A\"}\n"
+                                                "Initiator = \"A\"\n"
+                                                "Angle = 22.5\n"
+                                                "StartingAngle = 0\n"
+                                                "Iterations = 8\n");
+            stochastic_input >> stochastic;
+            stochastic.set_seed(42);
+            CHECK(stochastic.get_stochastic());
+
+            for (const LParser::LSystem2D *l_system : {&deterministic, &stochastic}) {
+                const std::string &initiator = l_system->get_initiator();
+                const unsigned int iterations = l_system->get_nr_iterations();
+                std::string walked;
+                LSystemIterator symbols(*l_system, iterations);
+                char symbol;
+                while (symbols.next(symbol)) walked += symbol;
+                // Long enough to be filled by every thread
+                CHECK(walked.size() > (uint64_t(1) << 16));
+
+                Parallel::set_nr_threads(4);
+                CHECK(LSystemExpansion::expand(*l_system, initiator, iterations) == walked);
+                CHECK(LSystemExpansion::expand(*l_system, initiator, iterations, walked.size()) == walked);
+                bool refused = false;
+                try {
+                    LSystemExpansion::expand(*l_system, initiator, iterations, walked.size() - 1);
+                }
+                catch (const std::bad_alloc &) {
+                    refused = true;
+                }
+                CHECK(refused);
+                Parallel::set_nr_threads(0);
+            }
+        });
+    }
+
+    void register_parallel_tests() {
+
+        // Exceptions of workers and of the calling thread reach the caller after every range has finished
+        add_test("parallel/exceptions", []() {
+            Parallel::set_nr_threads(4);
+            for (const std::size_t throwing : {std::size_t(0), std::size_t(2)}) {
+                std::atomic<std::size_t> visited(0);
+                bool caught = false;
+                try {
+                    Parallel::for_range("test", 4, 1, [&](const std::size_t begin, const std::size_t end) {
+                        visited += end - begin;
+                        if (begin == throwing) throw std::bad_alloc();
+                    });
+                }
+                catch (const std::bad_alloc &) {
+                    caught = true;
+                }
+                CHECK(caught);
+                CHECK(visited == 4);
+            }
+            Parallel::set_nr_threads(0);
+        });
+    }
+}
+
+int main(int argc, char const* argv[])
+{
+    std::string filter;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+    }
+
+    register_lighting_tests();
+    register_estimate_tests();
+    register_lsystem_tests();
+    register_parallel_tests();
+
+    Stats::set_enabled(true);
+    int failed_tests = 0;
+    for (const Test &i : tests())
+    {
+        if (!filter.empty() && i.name.find(filter) == std::string::npos) continue;
+        const int previous = failures;
+        try
+        {
+            i.run();
+        }
+        catch (const std::exception &exception)
+        {
+            std::cerr << i.name << ": " << exception.what() << std::endl;
+            failures++;
+        }
+        const bool passed = failures == previous;
+        if (!passed) failed_tests++;
+        std::cout << (passed ? "PASS " : "FAIL ") << i.name << std::endl;
+    }
+    return failed_tests == 0 ? 0 : 1;
+}
@@ -478,13 +478,16 @@ const char* LParser::ParserException::what() const throw ()
 }
 
 LParser::LSystem::LSystem() :
-	alphabet(), drawfunction(), initiator(""), angle(0.0), replacementrules(), nrIterations(0)
+	alphabet(), drawfunction(), initiator(""), angle(0.0), replacementrules(), stochastic(false), nrIterations(0), seed(0)
 {
+	compile_symbols();
 }
 
 LParser::LSystem::LSystem(LSystem const&system) :
-	alphabet(system.alphabet), drawfunction(system.drawfunction), initiator(system.initiator), angle(system.angle), replacementrules(system.replacementrules), nrIterations(system.nrIterations)
+	alphabet(system.alphabet), drawfunction(system.drawfunction), initiator(system.initiator), angle(system.angle), replacementrules(system.replacementrules), stochastic(system.stochastic), nrIterations(system.nrIterations), seed(system.seed)
 {
+	// The table points into the rules, so it is rebuilt for the copy
+	compile_symbols();
 }
 LParser::LSystem::~LSystem()
 {
@@ -498,11 +501,96 @@ LParser::LSystem& LParser::LSystem::operator=(LParser::LSystem const& system)
 	drawfunction.insert(system.drawfunction.begin(), system.drawfunction.end());
 	replacementrules.clear();
 	replacementrules.insert(system.replacementrules.begin(), system.replacementrules.end());
+	initiator = system.initiator;
 	angle = system.angle;
+	stochastic = system.stochastic;
 	nrIterations = system.nrIterations;
+	seed = system.seed;
+	compile_symbols();
 	return *this;
 }
 
+void LParser::LSystem::compile_symbols()
+{
+	for (Symbol& i : symbols)
+	{
+		i = Symbol{IGNORED, false, nullptr, 0};
+	}
+	for (const char& i : std::string("+-^&\\/|"))
+	{
+		symbols[static_cast<unsigned char>(i)].type = TURN;
+	}
+	symbols[static_cast<unsigned char>('(')].type = PUSH;
+	symbols[static_cast<unsigned char>('[')].type = PUSH;
+	symbols[static_cast<unsigned char>(')')].type = POP;
+	symbols[static_cast<unsigned char>(']')].type = POP;
+
+	for (const char& i : alphabet)
+	{
+		Symbol& x = symbols[static_cast<unsigned char>(i)];
+		std::map<char, bool>::const_iterator draw_entry = drawfunction.find(i);
+		x.type = draw_entry != drawfunction.end() && draw_entry->second ? DRAW : MOVE;
+		std::multimap<char, std::pair<double, std::string>>::const_iterator rule = replacementrules.find(i);
+		if (rule != replacementrules.end())
+		{
+			x.rewritten = true;
+			x.replacement = rule->second.second.data();
+			x.replacement_length = rule->second.second.size();
+		}
+	}
+
+	for (std::vector<StochasticRule>& i : stochastic_rules)
+	{
+		i.clear();
+	}
+	if (!stochastic) return;
+
+	// Alias table of every symbol (Vose), the chances of a symbol are scaled so they sum to its amount of rules
+	for (const char& i : alphabet)
+	{
+		std::vector<StochasticRule>& table = stochastic_rules[static_cast<unsigned char>(i)];
+		double sum = 0;
+		typedef std::multimap<char, std::pair<double, std::string>>::const_iterator rule_iterator;
+		std::pair<rule_iterator, rule_iterator> range = replacementrules.equal_range(i);
+		for (rule_iterator j = range.first; j != range.second; j++)
+		{
+			table.push_back(StochasticRule{&j->second.second, j->second.first, 0});
+			sum += j->second.first;
+		}
+		if (table.size() < 2 || !(sum > 0))
+		{
+			// A single rule, or chances that cannot be normalised, always pick the first rule
+			for (StochasticRule& j : table) j = StochasticRule{table.front().replacement, 1, 0};
+			continue;
+		}
+
+		std::vector<std::size_t> small;
+		std::vector<std::size_t> large;
+		for (std::size_t j = 0; j != table.size(); j++)
+		{
+			table[j].probability *= table.size() / sum;
+			table[j].alias = j;
+			(table[j].probability < 1 ? small : large).push_back(j);
+		}
+		while (!small.empty() && !large.empty())
+		{
+			const std::size_t l = small.back();
+			const std::size_t g = large.back();
+			small.pop_back();
+			table[l].alias = g;
+			table[g].probability -= 1 - table[l].probability;
+			if (table[g].probability < 1)
+			{
+				large.pop_back();
+				small.push_back(g);
+			}
+		}
+		// Left over columns only differ from 1 by rounding
+		for (const std::size_t& j : small) table[j].probability = 1;
+		for (const std::size_t& j : large) table[j].probability = 1;
+	}
+}
+
 std::set<char> const& LParser::LSystem::get_alphabet() const
 {
 	return alphabet;
@@ -510,7 +598,7 @@ std::set<char> const& LParser::LSystem::get_alphabet() const
 bool LParser::LSystem::draw(char c) const
 {
 	assert(get_alphabet().find(c) != get_alphabet().end());
-	return drawfunction.find(c)->second;
+	return get_symbol(c).type == DRAW;
 }
 std::string const& LParser::LSystem::get_replacement(char c) const
 {
@@ -518,34 +606,26 @@ std::string const& LParser::LSystem::get_replacement(char c) const
 	return replacementrules.find(c)->second.second;
 
 }
-std::string const LParser::LSystem::get_replacement_stochastic(char c) const {
-
-    // Verschillende Stackoverflow sources hier voor gebruikt
-
-    // Current replacement-rule
-    std::pair<char, std::pair<double, std::string>> current;
+std::string const& LParser::LSystem::get_replacement_stochastic(char c, uint64_t random) const
+{
+	assert(get_alphabet().find(c) != get_alphabet().end());
+	std::vector<StochasticRule> const& rules = stochastic_rules[static_cast<unsigned char>(c)];
+	if (rules.empty()) return get_replacement(c);
 
-    // Get first replacement with char c of alphabet
-    for (const std::pair<char, std::pair<double, std::string>> i : replacementrules) {
-        if (i.first == c) {
-            current = i;
-            break;
-        }
-    }
+	// High bits pick the column, the low bits decide between the column and its alias
+	const std::size_t column = static_cast<std::size_t>(((random >> 32) * rules.size()) >> 32);
+	const double u = static_cast<double>(random & 0xFFFFFFFFu) / 4294967296.0;
+	return *(u < rules[column].probability ? rules[column].replacement : rules[rules[column].alias].replacement);
+}
 
-    auto output = 0 + (rand() % static_cast<int>(100 - 0 + 1));
-    std::ignore = output;
+uint64_t LParser::LSystem::get_seed() const
+{
+	return seed;
+}
 
-    // Traverse probabilities
-    while ((0 + (rand() % static_cast<int>(100 - 0 + 1))) - (current.second.first * 100) > 1) {
-        for (const std::pair<char, std::pair<double, std::string>> i : replacementrules) {
-            if (i.first == c && i != current) {
-                current = i;
-                break;
-            }
-        }
-    }
-    return current.second.second;
+void LParser::LSystem::set_seed(uint64_t x)
+{
+	seed = x;
 }
 
 double LParser::LSystem::get_angle() const
@@ -620,6 +700,7 @@ std::istream& LParser::operator>>(std::istream& in, LParser::LSystem2D& system)
 	system.angle = parse_angle(parser, "Angle");
 	system.startingAngle = parse_angle(parser, "StartingAngle");
 	system.nrIterations = parse_iterations(parser);
+	system.compile_symbols();
 
 	return in;
 }
@@ -635,11 +716,13 @@ std::istream& LParser::operator>>(std::istream&in, LParser::LSystem3D& system)
 	stream_parser parser(in);
 	parse_alphabet(system.alphabet, parser);
 	parse_draw(system.alphabet, system.drawfunction, parser);
+	system.stochastic = false;
 	parse_rules(system.alphabet, system.replacementrules, parser, false);
 	system.initiator = parse_initiator(system.alphabet, parser, false);
 	system.angle = parse_angle(parser, "Angle");
 
 	system.nrIterations = parse_iterations(parser);
+	system.compile_symbols();
 
 	return in;
 }
@@ -19,9 +19,12 @@
 #ifndef L_PARSER_INCLUDED
 #define L_PARSER_INCLUDED
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <set>
+#include <vector>
 #include <exception>
 #include <cstdlib>
 #include <ctime>
@@ -114,6 +117,74 @@ namespace LParser
 			LSystem& operator=(LSystem const& system);
 
 		public:
+			/**
+			 * \brief Meaning of a symbol for the turtle, TURN covers every rotation
+			 */
+			enum SymbolType {
+				IGNORED = 0,
+				TURN,
+				PUSH,
+				POP,
+				DRAW,
+				MOVE
+			};
+
+			/**
+			 * \brief Entry of the symbol table, everything expansion and turtle need to know of a symbol
+			 */
+			struct Symbol {
+				/**
+				 * \brief meaning of the symbol for the turtle
+				 */
+				SymbolType type;
+				/**
+				 * \brief the symbol is part of the alphabet and replaced every iteration
+				 */
+				bool rewritten;
+				/**
+				 * \brief characters of the (first) replacement rule, nullptr if the symbol is not rewritten
+				 */
+				const char *replacement;
+				/**
+				 * \brief length of the replacement rule
+				 */
+				std::size_t replacement_length;
+			};
+
+			/**
+			 * \brief Column of the alias table of a symbol, the column is picked uniformly and then either keeps its own
+			 * rule or passes to its alias
+			 */
+			struct StochasticRule {
+				std::string const* replacement;
+				double probability;
+				std::size_t alias;
+			};
+
+			/**
+			 * \brief Returns the alias table of a character, empty if the l-system is not stochastic
+			 *
+			 * \param c	the character
+			 *
+			 * \return	a const reference to the table, one column per rule
+			 */
+			std::vector<StochasticRule> const& get_stochastic_rules(char c) const
+			{
+				return stochastic_rules[static_cast<unsigned char>(c)];
+			}
+
+			/**
+			 * \brief Returns the entry of the symbol table for a character, valid for every character
+			 *
+			 * \param c	the character
+			 *
+			 * \return	a const reference to the entry
+			 */
+			Symbol const& get_symbol(char c) const
+			{
+				return symbols[static_cast<unsigned char>(c)];
+			}
+
 			/**
 			 * \brief returns the Alphabet of the L-System
 			 *
@@ -140,13 +211,29 @@ namespace LParser
 			std::string const& get_replacement(char c) const;
 
             /**
-             * \brief Replacement function with chance. Returns the replacement string for a given character of the Alphabet
+             * \brief Replacement function with chance. Returns the replacement string for a given character of the Alphabet,
+             * chosen from its alias table in constant time
              *
              * \param c the character of the alphabet
+             * \param random uniformly distributed random value, e.g. from Random::child
              *
              * \return	replacement string
              */
-            std::string const get_replacement_stochastic(char c) const;
+            std::string const& get_replacement_stochastic(char c, uint64_t random) const;
+
+			/**
+			 * \brief Returns the seed of the stochastic replacements
+			 *
+			 * \return	the seed
+			 */
+			uint64_t get_seed() const;
+
+			/**
+			 * \brief Sets the seed of the stochastic replacements, the same seed gives the same string
+			 *
+			 * \param x	the seed
+			 */
+			void set_seed(uint64_t x);
 
 			/**
 			 * \brief Returns the angle of the L-System.
@@ -212,6 +299,26 @@ namespace LParser
          * \brief the number of replacements of the l-system
          */
 			unsigned int nrIterations;
+
+		        /**
+		         * \brief dense table of every character, built from the alphabet, draw function and rules
+		         */
+			Symbol symbols[256];
+
+		        /**
+		         * \brief alias table of every character with stochastic rules
+		         */
+			std::vector<StochasticRule> stochastic_rules[256];
+
+		        /**
+		         * \brief seed of the stochastic replacements
+		         */
+			uint64_t seed;
+
+			/**
+			 * \brief Rebuild the symbol table, called whenever the rules change
+			 */
+			void compile_symbols();
 	};
 
 